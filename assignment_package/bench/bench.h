@@ -0,0 +1,14 @@
+#pragma once
+#include <chrono>
+
+// seconds since a start time
+inline double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// fbm2D and sealedFbm2D per column under the sin and the hash backend
+void benchNoise();
+// getBlockAt on a tree of chunks against the chunk map
+void benchChunkMap();
+// chunks per second of single-chunk generation against 4 x 4 groups
+void benchGroup();
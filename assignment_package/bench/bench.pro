@@ -0,0 +1,48 @@
+# throughput of the hot paths of world generation and chunk lookup, build in release,
+# run with no arguments for every benchmark or with the names of some
+
+TARGET = MiniMinecraftBench
+TEMPLATE = app
+CONFIG += console
+CONFIG += c++1z
+CONFIG += release
+# chunks and the terrain need the gl types, no window is opened
+QT += core widgets
+win32 {
+    LIBS += -lopengl32
+}
+
+INCLUDEPATH += ../src ../include
+
+SOURCES += \
+    main.cpp \
+    noisebench.cpp \
+    chunkmapbench.cpp \
+    groupbench.cpp \
+    ../src/jobsystem.cpp \
+    ../src/openglcontext.cpp \
+    ../src/drawable.cpp \
+    ../src/scene/noise.cpp \
+    ../src/scene/biome.cpp \
+    ../src/scene/climatefield.cpp \
+    ../src/scene/biomemap.cpp \
+    ../src/scene/blocksection.cpp \
+    ../src/scene/faceculling.cpp \
+    ../src/scene/chunksnapshot.cpp \
+    ../src/scene/chunk.cpp \
+    ../src/scene/chunkmap.cpp \
+    ../src/scene/regionstore.cpp \
+    ../src/scene/rectangle.cpp \
+    ../src/scene/raindrop.cpp \
+    ../src/scene/snow.cpp \
+    ../src/scene/lightening.cpp \
+    ../src/scene/blockcursor.cpp \
+    ../src/scene/terrainart.cpp \
+    ../src/scene/terrain.cpp
+
+HEADERS += \
+    bench.h
+
+*-clang*|*-g++* {
+    QMAKE_CXXFLAGS += -ffp-contract=off
+}
@@ -0,0 +1,81 @@
+#include <iostream>
+#include <map>
+#include <vector>
+#include "bench.h"
+#include "scene/chunk.h"
+#include "scene/chunkmap.h"
+
+// the chunks loaded around the player, 12 x 12 of them
+static const int LOADED = 96;
+// probes per run
+static const int PROBES = 1 << 20;
+
+// the key of a chunk origin, as Terrain::hash
+static int64_t chunkKey(int x, int z) {
+    return (int64_t(x) << 32) + z;
+}
+
+// Terrain::getBlockAt before the chunk map, the origin by modulo, then count and find
+// on a tree of chunks
+static BlockType treeBlockAt(const std::map<int64_t, Chunk> &chunks, int x, int y, int z) {
+    int xo = x % 16 == 0 ? x : x < 0 ? x - (x % 16 + 16) : x - x % 16;
+    int zo = z % 16 == 0 ? z : z < 0 ? z - (z % 16 + 16) : z - z % 16;
+    if (!chunks.count(chunkKey(xo, zo))) {
+        return EMPTY;
+    }
+    return chunks.find(chunkKey(xo, zo))->second.blockAt(x - xo, y, z - zo);
+}
+
+// Terrain::getBlockAt with the chunk map, the origin by mask and a single find
+static BlockType mapBlockAt(const ChunkMap &chunks, int x, int y, int z) {
+    int xo = x & -16;
+    int zo = z & -16;
+    const Chunk* chunk = chunks.find(chunkKey(xo, zo));
+    if (chunk == nullptr) {
+        return EMPTY;
+    }
+    return chunk->blockAt(x - xo, y, z - zo);
+}
+
+// million lookups per second of a getBlockAt over a list of probes
+template <typename BlockAt>
+static double lookupRate(BlockAt blockAt, const std::vector<glm::ivec3> &probes, long &sink) {
+    auto start = std::chrono::steady_clock::now();
+    for (const glm::ivec3& p : probes) {
+        sink += blockAt(p.x, p.y, p.z);
+    }
+    return probes.size() / secondsSince(start) / 1e6;
+}
+
+// getBlockAt on a tree of chunks against the chunk map, for random probes around
+// the player like collision and npc queries and for short walks like raycasts
+void benchChunkMap() {
+    std::map<int64_t, Chunk> tree;
+    ChunkMap map;
+    for (int x = -LOADED; x < LOADED; x += 16) {
+        for (int z = -LOADED; z < LOADED; z += 16) {
+            uPtr<Chunk> chunk = mkU<Chunk>(nullptr, glm::vec4(x, 0, z, 1));
+            for (int i = 0; i < 16; i++) {
+                for (int k = 0; k < 16; k++) {
+                    chunk->fillColumn(i, k, 0, 128 + (i * 7 + k * 13) % 16, STONE);
+                }
+            }
+            tree.emplace(chunkKey(x, z), *chunk);
+            map.insert(chunkKey(x, z), std::move(chunk));
+        }
+    }
+    std::vector<glm::ivec3> random(PROBES), walk(PROBES);
+    uint32_t r = 1;
+    for (int i = 0; i < PROBES; i++) {
+        r = r * 1664525u + 1013904223u;
+        random[i] = glm::ivec3((int)(r >> 8) % 200 - 100, (int)(r >> 4) % 256, (int)(r >> 16) % 200 - 100);
+        walk[i] = glm::ivec3(i % 64 - 32, 130 + (i & 7), (i >> 6) % 64 - 32);
+    }
+    long sink = 0;
+    auto treeBlock = [&tree](int x, int y, int z) { return treeBlockAt(tree, x, y, z); };
+    auto mapBlock = [&map](int x, int y, int z) { return mapBlockAt(map, x, y, z); };
+    std::cout << "tree random " << lookupRate(treeBlock, random, sink) << " M/s, walk "
+              << lookupRate(treeBlock, walk, sink) << " M/s" << std::endl;
+    std::cout << "map  random " << lookupRate(mapBlock, random, sink) << " M/s, walk "
+              << lookupRate(mapBlock, walk, sink) << " M/s (" << (sink & 1) << ")" << std::endl;
+}
@@ -0,0 +1,69 @@
+#include <QDir>
+#include <QTemporaryDir>
+#include <iostream>
+#include "bench.h"
+#include "jobsystem.h"
+#include "scene/terrain.h"
+
+// 64 x 64 areas built by each run
+static const int GROUPS = 8;
+
+// chunks per second of building GROUPS areas as groups on a job system, from the
+// first area's base along x, return whether they match the given single chunks
+static double groupRate(Terrain &terrain, JobSystem &jobs, int baseX,
+                        const std::vector<uPtr<Chunk>> &singles, bool &matches) {
+    auto start = std::chrono::steady_clock::now();
+    for (int g = 0; g < GROUPS; g++) {
+        BiomeMap maps[16];
+        BiomeMap::buildGroup(baseX + g * 64, 0, 4, 4, maps);
+        terrain.buildFbmGroup(baseX + g * 64, 0, maps, jobs);
+    }
+    double rate = GROUPS * 16 / secondsSince(start);
+    matches = true;
+    for (int g = 0; g < GROUPS; g++) {
+        for (int i = 0; i < 16; i++) {
+            int x = baseX + g * 64 + i % 4 * 16;
+            int z = i / 4 * 16;
+            const Chunk& single = *singles[g * 16 + i];
+            const Chunk& grouped = *terrain.getChunk(x, z);
+            for (int y = 0; y < 256 && matches; y++) {
+                for (int k = 0; k < 256; k++) {
+                    matches = matches && single.blockAt(k % 16, y, k / 16) == grouped.blockAt(k % 16, y, k / 16);
+                }
+            }
+        }
+    }
+    return rate;
+}
+
+// chunks per second of single-chunk generation against 4 x 4 groups built from one
+// pass of noise, on every worker and on one, in a world made for the run
+void benchGroup() {
+    QTemporaryDir world;
+    QDir::setCurrent(world.path());
+    Terrain terrain(nullptr);
+    const int baseX = 4096;
+    std::vector<uPtr<Chunk>> singles;
+    auto start = std::chrono::steady_clock::now();
+    for (int g = 0; g < GROUPS; g++) {
+        for (int i = 0; i < 16; i++) {
+            singles.push_back(terrain.generateChunk(baseX + g * 64 + i % 4 * 16, i / 4 * 16));
+        }
+    }
+    double single = GROUPS * 16 / secondsSince(start);
+    JobSystem jobs;
+    // one area away from the measured ones first, the workers and the allocator warm up
+    BiomeMap warmup[16];
+    BiomeMap::buildGroup(-baseX, 0, 4, 4, warmup);
+    terrain.buildFbmGroup(-baseX, 0, warmup, jobs);
+    bool matches = false;
+    double group = groupRate(terrain, jobs, baseX, singles, matches);
+    std::cout << "single " << single << " chunks/s, group " << group << " chunks/s on "
+              << jobs.workerCount() << " workers, " << (matches ? "same" : "DIFFERENT") << " blocks" << std::endl;
+    // the same areas in a fresh terrain, so the gain of sharing the noise shows apart
+    Terrain oneWorkerTerrain(nullptr);
+    JobSystem oneWorker(1);
+    group = groupRate(oneWorkerTerrain, oneWorker, baseX, singles, matches);
+    std::cout << "group " << group << " chunks/s on 1 worker, "
+              << (matches ? "same" : "DIFFERENT") << " blocks" << std::endl;
+}
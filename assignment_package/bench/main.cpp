@@ -0,0 +1,29 @@
+#include <cstring>
+#include <iostream>
+#include "bench.h"
+
+// a benchmark and the name that picks it on the command line
+struct Benchmark {
+    const char *name;
+    void (*run)();
+};
+
+static const Benchmark BENCHMARKS[] = {
+    {"noise", benchNoise},
+    {"chunkmap", benchChunkMap},
+    {"group", benchGroup}
+};
+
+int main(int argc, char **argv) {
+    for (const Benchmark& b : BENCHMARKS) {
+        bool picked = argc < 2;
+        for (int i = 1; i < argc; i++) {
+            picked |= std::strcmp(argv[i], b.name) == 0;
+        }
+        if (picked) {
+            std::cout << "== " << b.name << std::endl;
+            b.run();
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,40 @@
+#include <iostream>
+#include "bench.h"
+#include "scene/noise.h"
+
+// columns of each run, a 256 x 256 block
+static const int SIDE = 256;
+
+// fbm2D and sealedFbm2D per column under the sin and the hash backend
+void benchNoise() {
+    noise::fbmParams p;
+    p.exponent = 1;
+    p.scaleX = 0.002f;
+    p.scaleY = 100.f;
+    p.scaleZ = 0.002f;
+    p.seed1 = 123.4f;
+    noise::worldSeed = 12345u;
+    const noise::Backend backends[] = {noise::SIN_BACKEND, noise::HASH_BACKEND};
+    for (noise::Backend backend : backends) {
+        noise::backend = backend;
+        const char *name = backend == noise::SIN_BACKEND ? "sin " : "hash";
+        // summed so the calls are not optimized away
+        volatile float sink = 0.f;
+        auto start = std::chrono::steady_clock::now();
+        for (int z = 0; z < SIDE; z++) {
+            for (int x = 0; x < SIDE; x++) {
+                sink = sink + noise::fbm2D(x * 0.02f, z * 0.02f, 0.5f, 8, 12.9898f, 4.1414f, 43858.5453f);
+            }
+        }
+        double fbm = secondsSince(start);
+        start = std::chrono::steady_clock::now();
+        for (int z = 0; z < SIDE; z++) {
+            for (int x = 0; x < SIDE; x++) {
+                sink = sink + noise::sealedFbm2D(x, z, p);
+            }
+        }
+        double sealed = secondsSince(start);
+        std::cout << name << " fbm2D " << fbm * 1e9 / (SIDE * SIDE) << " ns/column, sealedFbm2D "
+                  << sealed * 1e9 / (SIDE * SIDE) << " ns/column" << std::endl;
+    }
+}
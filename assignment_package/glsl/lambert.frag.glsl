@@ -142,6 +142,10 @@ void main()
         }
     }
     else {
+        // chunk faces repeat their tile, fs_UV is the corner of the tile
+        if (fs_Col.w > 0.5) {
+            uv += fract(fs_Col.xy) * 0.98 / 16.0;
+        }
         if (fs_Animated >= 1 - 1e-5 && fs_Animated <=1 + 1e-5) {
             float offset = (int(u_Time * 0.1) % 16) / 256.0;
             uv.x += offset;
@@ -29,6 +29,12 @@ in vec2 vs_UV;              // The array of vertex texture coordinates passed to
 in float vs_Cosine;
 in float vs_Animated;
 
+uniform int u_Packed;       // 1 when drawing a chunk, whose vertices are packed into vs_Packed
+uniform vec3 u_ChunkOrigin; // The world position of the chunk being drawn
+in uvec2 vs_Packed;         // x: position (5, 9, 5 bits) and face (3 bits)
+                            // y: tile (4, 4 bits), cosine (4 bits), animated (4 bits),
+                            //    cross decal (1 bit) and untextured (1 bit)
+
 out vec4 fs_Nor;            // The array of normals that has been transformed by u_ModelInvTr. This is implicitly passed to the fragment shader.
 out vec4 fs_LightVec;       // The direction in which our virtual light lies, relative to each vertex. This is implicitly passed to the fragment shader.
 out vec4 fs_Col;            // The color of each vertex. This is implicitly passed to the fragment shader.
@@ -39,12 +45,13 @@ out float fs_Animated;
 const vec4 lightDir = vec4(1.2,1,1.4,0);  // The direction of our virtual light, which is used to compute the shading of
                                         // the geometry in the fragment shader.
 
+// Outward normals of the chunk faces: left, right, front, back, top, bottom
+const vec3 faceNormals[6] = vec3[6](vec3(-1, 0, 0), vec3(1, 0, 0), vec3(0, 0, 1),
+                                    vec3(0, 0, -1), vec3(0, 1, 0), vec3(0, -1, 0));
+
 void main()
 {
     fs_UV = vs_UV;    // Pass the vertex UVs to the fragment shader for interpolation
-
-    vec2 uv = fs_UV;
-
     fs_Col = vs_Col;                         // Pass the vertex colors to the fragment shader for interpolation
     fs_Cosine = vs_Cosine;
     fs_Animated = vs_Animated;
@@ -53,6 +60,51 @@ void main()
 
     vec4 nor = vs_Nor;
 
+    if (u_Packed == 1) {
+        // Unpack a chunk vertex
+        vec3 local = vec3(float(vs_Packed.x & 31u),
+                          float((vs_Packed.x >> 5) & 511u),
+                          float((vs_Packed.x >> 14) & 31u));
+        int face = int((vs_Packed.x >> 19) & 7u);
+        vec3 normal = faceNormals[face];
+        // The block-space position along the face decides which part of the tile to sample,
+        // so faces merged across several blocks repeat their tile
+        vec2 repeat;
+        if (face == 0) {
+            repeat = local.zy;
+        } else if (face == 1) {
+            repeat = vec2(-local.z, local.y);
+        } else if (face == 2) {
+            repeat = local.xy;
+        } else if (face == 3) {
+            repeat = vec2(-local.x, local.y);
+        } else if (face == 4) {
+            repeat = vec2(local.x, -local.z);
+        } else {
+            repeat = local.xz;
+        }
+        fs_Cosine = float((vs_Packed.y >> 8) & 15u);
+        fs_Animated = float((vs_Packed.y >> 12) & 15u);
+        // Lava and water sides lay their tile on its side
+        if (fs_Animated == 1.0 && face < 4) {
+            repeat = vec2(repeat.y, -repeat.x);
+        }
+        // Crossing decals sit half a block inside their face
+        if ((vs_Packed.y & 65536u) != 0u) {
+            local -= 0.5 * normal;
+        }
+        if ((vs_Packed.y & 131072u) != 0u) {
+            fs_UV = vec2(-1, -1);
+        } else {
+            fs_UV = (vec2(float(vs_Packed.y & 15u), float((vs_Packed.y >> 4) & 15u)) + 0.01) / 16.0;
+        }
+        fs_Col = vec4(repeat, 0, 1);
+        pos = vec4(u_ChunkOrigin + local, 1);
+        nor = vec4(normal, 0);
+    }
+
+    vec2 uv = fs_UV;
+
 
     if ((uv.x < 0 || uv.y < 0)) {
         if (fs_Animated >= 2 - 1e-5 && fs_Animated <= 2 + 1e-5) {
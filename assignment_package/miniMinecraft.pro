@@ -28,6 +28,8 @@ RESOURCES += glsl.qrc \
     QMAKE_CXXFLAGS += -Wall -Wextra -pedantic -Winit-self
     QMAKE_CXXFLAGS += -Wno-strict-aliasing
     QMAKE_CXXFLAGS += -fno-omit-frame-pointer
+    # no fused multiply-adds, so worlds generate the same on every cpu
+    QMAKE_CXXFLAGS += -ffp-contract=off
 }
 linux-clang*|linux-g++*|macx-clang*|macx-g++* {
     message("Enabling stack protector")
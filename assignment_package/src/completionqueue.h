@@ -0,0 +1,62 @@
+#ifndef COMPLETIONQUEUE_H
+#define COMPLETIONQUEUE_H
+
+#include <atomic>
+#include <vector>
+
+// a lock-free queue that any number of worker threads push finished work into,
+// and a single thread (the main thread) drains all at once, values are moved
+// in and out, never copied
+// pushes go onto a linked stack with compare-and-swap, the drain swaps out the
+// whole stack in one exchange, so there is no pop and no ABA problem
+template <typename T>
+class CompletionQueue
+{
+private:
+    struct Node
+    {
+        T value;
+        Node* next;
+    };
+    // the newest node, each node links to the one pushed before it
+    std::atomic<Node*> m_head;
+
+public:
+    CompletionQueue() : m_head(nullptr) {}
+    ~CompletionQueue() {
+        std::vector<T> rest;
+        drain(rest);
+    }
+    CompletionQueue(const CompletionQueue&) = delete;
+    CompletionQueue& operator=(const CompletionQueue&) = delete;
+
+    // push a value, from any thread
+    void push(T value) {
+        Node* node = new Node{std::move(value), m_head.load(std::memory_order_relaxed)};
+        while (!m_head.compare_exchange_weak(node->next, node,
+                                             std::memory_order_release,
+                                             std::memory_order_relaxed)) {}
+    }
+
+    // move every value pushed so far to the end of out, oldest first,
+    // only one thread may drain
+    void drain(std::vector<T>& out) {
+        Node* node = m_head.exchange(nullptr, std::memory_order_acquire);
+        // reverse the stack to get the values in the order they were pushed
+        Node* oldest = nullptr;
+        while (node != nullptr) {
+            Node* next = node->next;
+            node->next = oldest;
+            oldest = node;
+            node = next;
+        }
+        while (oldest != nullptr) {
+            Node* next = oldest->next;
+            out.push_back(std::move(oldest->value));
+            delete oldest;
+            oldest = next;
+        }
+    }
+};
+
+#endif // COMPLETIONQUEUE_H
@@ -1,12 +1,15 @@
 #include "drawable.h"
 #include <la.h>
 
+GLuint Drawable::sharedQuadIdx = 0;
+int Drawable::sharedQuadCount = 0;
+
 Drawable::Drawable(OpenGLContext* context)
-    : bufIdx0(), bufVer0(),
+    : count0(0), bufIdx0(), bufVer0(),
       idxBound0(false), verBound0(false),
-      bufIdx1(), bufVer1(),
+      count1(0), bufIdx1(), bufVer1(),
       idxBound1(false), verBound1(false),
-      context(context)
+      context(context), sharedIdx0(false), sharedIdx1(false)
 {}
 
 Drawable::~Drawable()
@@ -32,6 +35,16 @@ GLenum Drawable::drawMode()
     return GL_TRIANGLES;
 }
 
+bool Drawable::isPacked()
+{
+    return false;
+}
+
+glm::vec4 Drawable::packedOrigin()
+{
+    return glm::vec4(0.f, 0.f, 0.f, 1.f);
+}
+
 int Drawable::elemCount0()
 {
     return count0;
@@ -58,6 +71,10 @@ void Drawable::generateVer0()
 
 bool Drawable::bindIdx0()
 {
+    if (sharedIdx0) {
+        context->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sharedQuadIdx);
+        return true;
+    }
     if(idxBound0) {
         context->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, bufIdx0);
     }
@@ -88,6 +105,10 @@ void Drawable::generateVer1()
 
 bool Drawable::bindIdx1()
 {
+    if (sharedIdx1) {
+        context->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sharedQuadIdx);
+        return true;
+    }
     if(idxBound1) {
         context->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, bufIdx1);
     }
@@ -101,3 +122,43 @@ bool Drawable::bindVer1()
     }
     return verBound1;
 }
+
+void Drawable::useSharedQuadIdx0(int quadCount)
+{
+    reserveSharedQuads(quadCount);
+    sharedIdx0 = true;
+    count0 = quadCount * 6;
+}
+
+void Drawable::useSharedQuadIdx1(int quadCount)
+{
+    reserveSharedQuads(quadCount);
+    sharedIdx1 = true;
+    count1 = quadCount * 6;
+}
+
+void Drawable::reserveSharedQuads(int quadCount)
+{
+    if (quadCount <= sharedQuadCount) {
+        return;
+    }
+    // Grow to at least twice the old size so remeshing bigger chunks rarely re-uploads
+    int count = std::max(quadCount, std::max(sharedQuadCount * 2, 4096));
+    std::vector<GLuint> idx;
+    idx.reserve(count * 6);
+    for (int i = 0; i < count; i++) {
+        GLuint base = i * 4;
+        idx.push_back(base);
+        idx.push_back(base + 1);
+        idx.push_back(base + 2);
+        idx.push_back(base);
+        idx.push_back(base + 2);
+        idx.push_back(base + 3);
+    }
+    if (sharedQuadIdx == 0) {
+        context->glGenBuffers(1, &sharedQuadIdx);
+    }
+    context->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sharedQuadIdx);
+    context->glBufferData(GL_ELEMENT_ARRAY_BUFFER, idx.size() * sizeof(GLuint), idx.data(), GL_STATIC_DRAW);
+    sharedQuadCount = count;
+}
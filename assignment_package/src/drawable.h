@@ -36,6 +36,10 @@ public:
 
     // Getter functions for various GL data
     virtual GLenum drawMode();
+    // Whether the VBOs hold packed chunk vertices (two GLuints each)
+    // instead of 16 floats, and the world position they are relative to
+    virtual bool isPacked();
+    virtual glm::vec4 packedOrigin();
     int elemCount0();
     int elemCount1();
 
@@ -52,4 +56,18 @@ public:
 
     bool bindIdx1();
     bool bindVer1();
+
+    // Draw the given number of quads (vertices 4n..4n+3 each) with the index
+    // buffer shared by all Drawables instead of generating bufIdx
+    void useSharedQuadIdx0(int quadCount);
+    void useSharedQuadIdx1(int quadCount);
+
+private:
+    bool sharedIdx0; // Set to TRUE by useSharedQuadIdx0(), bindIdx0() then binds the shared buffer
+    bool sharedIdx1;
+
+    static GLuint sharedQuadIdx; // 0,1,2,0,2,3 pattern repeated for every quad
+    static int sharedQuadCount;  // The number of quads sharedQuadIdx holds
+    // Grow the shared quad index buffer to hold at least quadCount quads
+    void reserveSharedQuads(int quadCount);
 };
@@ -0,0 +1,162 @@
+#include "jobsystem.h"
+#include <algorithm>
+
+thread_local JobSystem* JobSystem::t_system = nullptr;
+thread_local int JobSystem::t_worker = -1;
+
+// heap order, the job with the smallest priority on top
+bool JobSystem::runsLater(const JobHandle& a, const JobHandle& b) {
+    return a->m_priority > b->m_priority;
+}
+
+Job::Job(std::function<void()> work, float priority, JobLane lane, sPtr<CancelToken> token) :
+    m_work(work), m_cancelled(), m_priority(priority), m_lane(lane), m_token(token),
+    m_waiting(1), m_mutex(), m_finished(false), m_dependents()
+{}
+
+// run a function instead of the work once the job is cancelled
+void Job::onCancel(std::function<void()> cancelled) {
+    m_cancelled = cancelled;
+}
+
+// start a number of workers, one per core but the main thread when not positive
+JobSystem::JobSystem(int workers) :
+    m_queued(0), m_stop(false), m_nextQueue(0)
+{
+    if (workers <= 0) {
+        workers = std::max(1, (int)std::thread::hardware_concurrency() - 1);
+    }
+    for (int i = 0; i < workers; i++) {
+        m_queues.push_back(mkU<Queue>());
+    }
+    for (int i = 0; i < workers; i++) {
+        m_threads.push_back(std::thread(&JobSystem::workerLoop, this, i));
+    }
+}
+
+// stop the workers once their running jobs are done, queued jobs are dropped
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for (std::thread& thread : m_threads) {
+        thread.join();
+    }
+}
+
+int JobSystem::workerCount() const {
+    return (int)m_threads.size();
+}
+
+// create a job, it does not run before it is submitted
+JobHandle JobSystem::create(std::function<void()> work, float priority,
+                            JobLane lane, sPtr<CancelToken> token) {
+    return mkS<Job>(work, priority, lane, token);
+}
+
+// make a job wait for another to finish, before the job is submitted
+void JobSystem::depend(const JobHandle& job, const JobHandle& on) {
+    std::lock_guard<std::mutex> lock(on->m_mutex);
+    if (!on->m_finished) {
+        job->m_waiting++;
+        on->m_dependents.push_back(job);
+    }
+}
+
+// queue a job once its dependencies are done
+void JobSystem::submit(const JobHandle& job) {
+    release(job);
+}
+
+// run the ready main lane jobs, most urgent first, on the main thread
+void JobSystem::runMainJobs() {
+    // main lane jobs made ready by these wait for the next call
+    std::vector<JobHandle> jobs;
+    m_mainReady.drain(jobs);
+    std::stable_sort(jobs.begin(), jobs.end(), [](const JobHandle& a, const JobHandle& b) {
+        return runsLater(b, a);
+    });
+    for (const JobHandle& job : jobs) {
+        execute(job);
+    }
+}
+
+void JobSystem::workerLoop(int index) {
+    t_system = this;
+    t_worker = index;
+    while (!m_stop) {
+        JobHandle job = take(index);
+        if (job != nullptr) {
+            execute(job);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        m_wake.wait(lock, [this]() { return m_stop || m_queued > 0; });
+    }
+}
+
+// pop the most urgent job of a worker, or steal one from the others
+JobHandle JobSystem::take(int index) {
+    int count = (int)m_queues.size();
+    for (int i = 0; i < count; i++) {
+        Queue& queue = *m_queues[(index + i) % count];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.jobs.empty()) {
+            std::pop_heap(queue.jobs.begin(), queue.jobs.end(), runsLater);
+            JobHandle job = queue.jobs.back();
+            queue.jobs.pop_back();
+            m_queued--;
+            return job;
+        }
+    }
+    return nullptr;
+}
+
+// run or cancel a job, then release the jobs waiting for it
+void JobSystem::execute(const JobHandle& job) {
+    if (job->m_token != nullptr && job->m_token->isCancelled()) {
+        if (job->m_cancelled) {
+            job->m_cancelled();
+        }
+    } else {
+        job->m_work();
+    }
+    std::vector<JobHandle> dependents;
+    {
+        std::lock_guard<std::mutex> lock(job->m_mutex);
+        job->m_finished = true;
+        dependents.swap(job->m_dependents);
+    }
+    for (const JobHandle& dependent : dependents) {
+        release(dependent);
+    }
+}
+
+// count down a job's dependencies and queue it once they are all done
+void JobSystem::release(const JobHandle& job) {
+    if (--job->m_waiting == 0) {
+        enqueue(job);
+    }
+}
+
+void JobSystem::enqueue(const JobHandle& job) {
+    if (job->m_lane == MAIN_LANE) {
+        m_mainReady.push(job);
+        return;
+    }
+    // a worker keeps the jobs it releases, the rest are spread over all workers
+    int index = t_system == this ? t_worker : (int)(m_nextQueue++ % m_queues.size());
+    Queue& queue = *m_queues[index];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.jobs.push_back(job);
+        std::push_heap(queue.jobs.begin(), queue.jobs.end(), runsLater);
+    }
+    m_queued++;
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+    }
+    m_wake.notify_one();
+}
@@ -0,0 +1,123 @@
+#ifndef JOBSYSTEM_H
+#define JOBSYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "smartpointerhelp.h"
+#include "completionqueue.h"
+
+// shared by the jobs of one piece of work, once cancelled
+// the jobs holding it that have not started yet are skipped
+class CancelToken
+{
+private:
+    std::atomic<bool> m_cancelled;
+
+public:
+    CancelToken() : m_cancelled(false) {}
+    void cancel() { m_cancelled = true; }
+    bool isCancelled() const { return m_cancelled; }
+};
+
+enum JobLane : unsigned char
+{
+    // any worker thread
+    WORKER_LANE,
+    // the main thread, inside JobSystem::runMainJobs,
+    // for work on state that only the main thread may touch
+    MAIN_LANE
+};
+
+class Job
+{
+    friend class JobSystem;
+private:
+    std::function<void()> m_work;
+    // run instead of the work once the job is cancelled, on the same lane
+    std::function<void()> m_cancelled;
+    // jobs with a smaller priority run first, usually the distance to the camera
+    float m_priority;
+    JobLane m_lane;
+    sPtr<CancelToken> m_token;
+    // unfinished dependencies, plus one until the job is submitted
+    std::atomic<int> m_waiting;
+    // guards m_finished and m_dependents
+    std::mutex m_mutex;
+    bool m_finished;
+    // jobs that wait for this one to finish
+    std::vector<sPtr<Job>> m_dependents;
+
+public:
+    Job(std::function<void()> work, float priority, JobLane lane, sPtr<CancelToken> token);
+    // run a function instead of the work once the job is cancelled
+    void onCancel(std::function<void()> cancelled);
+};
+
+typedef sPtr<Job> JobHandle;
+
+// an engine-owned pool of worker threads, each with its own queue of jobs ordered
+// by priority, an idle worker steals the most urgent job of the others,
+// jobs can wait for other jobs and can be cancelled before they start
+class JobSystem
+{
+private:
+    // the ready jobs of one worker, kept as a heap on priority
+    class Queue
+    {
+    public:
+        std::mutex mutex;
+        std::vector<JobHandle> jobs;
+    };
+    std::vector<uPtr<Queue>> m_queues;
+    std::vector<std::thread> m_threads;
+    // ready main lane jobs, pushed from any thread and drained by runMainJobs
+    CompletionQueue<JobHandle> m_mainReady;
+    // idle workers sleep until jobs are queued
+    std::mutex m_sleepMutex;
+    std::condition_variable m_wake;
+    // jobs in the worker queues
+    std::atomic<int> m_queued;
+    std::atomic<bool> m_stop;
+    // spreads the jobs submitted from outside the workers over their queues
+    std::atomic<unsigned> m_nextQueue;
+
+    // the worker running on this thread, if any
+    static thread_local JobSystem* t_system;
+    static thread_local int t_worker;
+
+    // heap order, the job with the smallest priority on top
+    static bool runsLater(const JobHandle& a, const JobHandle& b);
+    void workerLoop(int index);
+    // pop the most urgent job of a worker, or steal one from the others
+    JobHandle take(int index);
+    // run or cancel a job, then release the jobs waiting for it
+    void execute(const JobHandle& job);
+    // count down a job's dependencies and queue it once they are all done
+    void release(const JobHandle& job);
+    void enqueue(const JobHandle& job);
+
+public:
+    // start a number of workers, one per core but the main thread when not positive
+    explicit JobSystem(int workers = 0);
+    // stop the workers once their running jobs are done, queued jobs are dropped
+    ~JobSystem();
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    int workerCount() const;
+    // create a job, it does not run before it is submitted
+    JobHandle create(std::function<void()> work, float priority = 0.f,
+                     JobLane lane = WORKER_LANE, sPtr<CancelToken> token = nullptr);
+    // make a job wait for another to finish, before the job is submitted
+    void depend(const JobHandle& job, const JobHandle& on);
+    // queue a job once its dependencies are done
+    void submit(const JobHandle& job);
+    // run the ready main lane jobs, most urgent first, on the main thread
+    void runMainJobs();
+};
+
+#endif // JOBSYSTEM_H
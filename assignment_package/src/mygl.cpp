@@ -4,6 +4,14 @@
 #include <QApplication>
 #include <QKeyEvent>
 
+// the number of job worker threads, one per core but the main thread when 0
+static const int WORKER_THREADS = 0;
+// the most chunks unloaded in one frame
+static const int UNLOADS_PER_FRAME = 4;
+// saved chunks are written once this many are waiting, or after a while
+static const int SAVE_BATCH = 32;
+static const int64_t SAVE_INTERVAL_MS = 10000;
+
 MyGL::MyGL(QWidget *parent)
     : OpenGLContext(parent),
       mp_worldAxes(mkU<WorldAxes>(this)),
@@ -13,6 +21,8 @@ MyGL::MyGL(QWidget *parent)
       mp_camera(mkU<Camera>()), mp_terrain(mkU<Terrain>(this)), mp_player(mkU<Player>(this)),
       /*mp_thirdperson(mkU<ThirdPerson>(this, glm::vec3(), glm::vec3())),*/ mp_lsystem(mkU<LSystem>(mp_terrain.get())),
       mp_npcsystem(mkU<NPCSystem>(this, mp_terrain.get())),
+      mp_scheduler(mkU<ChunkScheduler>(mp_terrain.get())), mp_jobs(mkU<JobSystem>(WORKER_THREADS)),
+      m_streaming(), m_flushing(false), m_lastFlush(0),
       mp_texture(mkU<Texture>(this)), mp_normalMap(mkU<Texture>(this)), m_time(0), timer(),
       currentTime(0), elapsedTime(0), lastPos(), flyLastFrame(0), jumpLastFrame(0)
 {
@@ -33,17 +43,31 @@ MyGL::MyGL(QWidget *parent)
 //    mp_player->person = mp_thirdperson.get();
     currentTime = QDateTime::currentMSecsSinceEpoch();
 
-    // initial 16 chunk creation has been done in terrain's constructor
-    // initial 16 chunk update for L-system and assests
-    mp_lsystem->update(Rect64(0, 0));
-    for (int i = 0; i < 16; i++) {
-        mp_terrain->placeAssets(Rect16(i / 4 * 16, i % 4 * 16));
+    // initial 16 chunk creation, on the workers once they are up
+    mp_terrain->createFirstArea(*mp_jobs);
+    // initial chunk update for L-system and assests, unless they were loaded,
+    // rivers depend on the session, so chunks saved as their edits alone get none
+    for (const Rect16& rect : mp_terrain->m_undecorated) {
+        if (!mp_terrain->getChunk(rect.xmin, rect.zmin)->awaitsReplay()) {
+            mp_lsystem->update(rect);
+        }
+    }
+    for (const Rect16& rect : mp_terrain->m_undecorated) {
+        mp_terrain->placeAssets(rect);
+    }
+    // then bring back the edits of chunks saved as their edits alone
+    for (const Rect16& rect : mp_terrain->m_undecorated) {
+        mp_terrain->getChunk(rect.xmin, rect.zmin)->replayEdits();
     }
+    mp_terrain->m_undecorated.clear();
 }
 
 MyGL::~MyGL()
 {
     makeCurrent();
+    // save the world before leaving
+    mp_terrain->saveChunks();
+    mp_terrain->flushSaves();
     glDeleteVertexArrays(1, &vao);
     mp_terrain->destroy();
     mp_npcsystem->destroy();
@@ -276,30 +300,206 @@ void MyGL::timerUpdate()
     MoveMouseToCenter();
     lastPos = QCursor::pos();
 
-    Rect16 rect(0, 0);
-    if (ThreadData::workerRunning == 0) {
-        if (mp_terrain->checkBooarder((int)(camPos[0]), (int)(camPos[2]), rect)) {
-            ThreadData::workerRunning = 1;
-            Worker *worker = new Worker(mp_terrain.get(), mp_lsystem.get(), rect);
-            QThreadPool::globalInstance()->start(worker);
+    // stream in the chunks around the player, then remesh what was edited
+    // or streamed in since the last frame, every chunk is meshed on its own
+    // from a copy, so editing can go on meanwhile
+    mp_scheduler->update(camPos, mp_camera->look, (float)elapsedTime);
+    streamChunks();
+    mp_jobs->runMainJobs();
+    unloadChunks();
+    for (Chunk* chunk : mp_terrain->dirtyChunks()) {
+        glm::vec4 origin = chunk->packedOrigin();
+        sPtr<RemeshJob> remesh = mkS<RemeshJob>();
+        remesh->prepare(chunk);
+        queueRemesh(remesh, mp_scheduler->priority(Rect16((int)origin.x, (int)origin.z)));
+    }
+
+    // update movement of npcs
+    mp_npcsystem->update((float)elapsedTime);
+
+    update();
+}
+
+// every chunk streams in through a chain of jobs sharing a cancel token:
+// generate its blocks on a worker, decorate it on this thread as rivers,
+// assets and clouds write across chunk borders, then mesh it on a worker
+// and upload it here, the chunks the scheduler ranks most urgent run first
+void MyGL::streamChunks() {
+    for (auto it = m_streaming.begin(); it != m_streaming.end(); it++) {
+        if (mp_scheduler->outOfRange(it->second->rect)) {
+            it->second->token->cancel();
         }
-    } else if (ThreadData::workerRunning == 2) {
-        rect = ThreadData::workerRect;
-        if (mp_terrain->hasChunk(rect.xmid(), rect.zmid())) {
-            Chunk* chunk = mp_terrain->getChunk(rect.xmid(), rect.zmid());
-            chunk->updateSelf(&(ThreadData::info));
-            chunk->updateNeighbor(&(ThreadData::linfo), &(ThreadData::rinfo),
-                                  &(ThreadData::finfo), &(ThreadData::binfo));
+    }
+    // keep the workers busy with twice as many chunks as there are workers
+    size_t limit = (size_t)mp_jobs->workerCount() * 2;
+    if (m_streaming.size() >= limit) {
+        return;
+    }
+    std::vector<ChunkRequest> requests;
+    mp_scheduler->request(limit - m_streaming.size(), requests);
+    std::map<int64_t, sPtr<StreamingGroup>> groups;
+    std::map<int64_t, JobHandle> groupJobs;
+    streamGroups(requests, groups, groupJobs);
+    for (const ChunkRequest& request : requests) {
+        const Rect16& rect = request.rect;
+        int64_t key = mp_terrain->hash(rect.xmin, rect.zmin);
+        sPtr<StreamingChunk> streaming = mkS<StreamingChunk>(rect);
+        m_streaming[key] = streaming;
+        float priority = request.priority;
+        Terrain* terrain = mp_terrain.get();
+        sPtr<RemeshJob> remesh = mkS<RemeshJob>();
+
+        JobHandle generate = mp_jobs->create([terrain, streaming]() {
+            const Rect16 &rect = streaming->rect;
+            const BiomeMap* map = nullptr;
+            if (streaming->group != nullptr) {
+                map = streaming->group->map(rect.xmin, rect.zmin);
+            }
+            streaming->chunk = terrain->loadChunk(rect.xmin, rect.zmin, map);
+            // a chunk saved as its edits alone comes back generated but undecorated
+            streaming->loaded = streaming->chunk != nullptr && !streaming->chunk->awaitsReplay();
+            if (streaming->chunk == nullptr) {
+                streaming->chunk = terrain->generateChunk(rect.xmin, rect.zmin, map);
+            }
+        }, priority, WORKER_LANE, streaming->token);
+        // the chunk's biome map comes from its group when it streams in with its neighbors
+        auto group = groupJobs.find(mp_terrain->hash(rect.xmin & -64, rect.zmin & -64));
+        if (group != groupJobs.end()) {
+            streaming->group = groups[group->first];
+            streaming->group->tokens.push_back(streaming->token);
+            mp_jobs->depend(generate, group->second);
+        }
+
+        JobHandle decorate = mp_jobs->create([this, key, streaming, remesh]() {
+            Rect16 rect = streaming->rect;
+            Chunk* chunk = mp_terrain->insertChunk(std::move(streaming->chunk));
+            // a saved chunk already has its rivers, assets and clouds
+            if (!streaming->loaded) {
+                // rivers depend on the session, a chunk saved as its edits alone had none
+                if (!chunk->awaitsReplay()) {
+                    mp_lsystem->update(rect);
+                }
+                mp_terrain->placeAssets(rect);
+                mp_terrain->createCloud(rect.xmin, rect.zmin);
+            }
+            chunk->replayEdits();
+            mp_terrain->updateRainHeights(rect.xmin, rect.zmin);
             updateWeather(rect.xmid(), rect.zmid());
             mp_npcsystem->birthNPC(rect);
+            remesh->prepare(chunk);
+            m_streaming.erase(key);
+        }, priority, MAIN_LANE, streaming->token);
+        // a cancelled chunk may be requested again once the player comes back
+        decorate->onCancel([this, key, rect]() {
+            mp_scheduler->cancelled(rect);
+            m_streaming.erase(key);
+        });
+
+        mp_jobs->depend(decorate, generate);
+        // the chunk is in the terrain once decorated, so its meshing is not cancelled,
+        // when the chunk is cancelled the remesh has nothing to mesh
+        JobHandle upload = queueRemesh(remesh, priority, decorate);
+        JobHandle shown = mp_jobs->create([this, rect]() {
+            mp_scheduler->visible(rect);
+        }, priority, MAIN_LANE);
+        mp_jobs->depend(shown, upload);
+        mp_jobs->submit(shown);
+        mp_jobs->submit(generate);
+        mp_jobs->submit(decorate);
+    }
+    for (auto& job : groupJobs) {
+        mp_jobs->submit(job.second);
+    }
+}
+
+// group the requested chunks of each 64 x 64 area when there are several and they fill
+// at least half the block of chunks around them, each group gets a job computing their
+// biome maps in one pass with the noise shared across chunk borders, see
+// Terrain::buildFbmGroup, the jobs are created but not submitted
+void MyGL::streamGroups(const std::vector<ChunkRequest> &requests,
+                        std::map<int64_t, sPtr<StreamingGroup>> &groups,
+                        std::map<int64_t, JobHandle> &jobs) {
+    std::map<int64_t, std::vector<Rect16>> areas;
+    std::map<int64_t, float> priorities;
+    for (const ChunkRequest& request : requests) {
+        int64_t area = mp_terrain->hash(request.rect.xmin & -64, request.rect.zmin & -64);
+        areas[area].push_back(request.rect);
+        // the requests come most urgent first
+        priorities.emplace(area, request.priority);
+    }
+    for (auto& area : areas) {
+        const std::vector<Rect16>& rects = area.second;
+        int xmin = rects[0].xmin, xmax = rects[0].xmin;
+        int zmin = rects[0].zmin, zmax = rects[0].zmin;
+        for (const Rect16& rect : rects) {
+            xmin = std::min(xmin, rect.xmin);
+            xmax = std::max(xmax, rect.xmin);
+            zmin = std::min(zmin, rect.zmin);
+            zmax = std::max(zmax, rect.zmin);
+        }
+        int chunksX = (xmax - xmin) / 16 + 1;
+        int chunksZ = (zmax - zmin) / 16 + 1;
+        if (rects.size() < 2 || (int)rects.size() * 2 < chunksX * chunksZ) {
+            continue;
         }
-        ThreadData::workerRunning = 0;
+        sPtr<StreamingGroup> group = mkS<StreamingGroup>(xmin, zmin, chunksX, chunksZ);
+        groups[area.first] = group;
+        jobs[area.first] = mp_jobs->create([group]() {
+            group->build();
+        }, priorities[area.first]);
     }
+}
 
-    // update movement of npcs
-    mp_npcsystem->update((float)elapsedTime);
+// unload a few chunks beyond the unload radius and the npcs on them, the chunks
+// are dropped and generated again when the player comes back
+void MyGL::unloadChunks() {
+    std::vector<Rect16> rects;
+    mp_scheduler->unloadable(UNLOADS_PER_FRAME, rects);
+    bool unloaded = false;
+    for (const Rect16& rect : rects) {
+        // a chunk still being meshed is unloaded in a later frame
+        unloaded |= mp_terrain->unloadChunk(rect.xmin, rect.zmin);
+    }
+    if (unloaded) {
+        mp_npcsystem->removeUnloaded();
+    }
+    // write the chunks saved on unloading in a batch on a worker, one batch at a time
+    int pending = mp_terrain->savesPending();
+    if (m_flushing || pending == 0 ||
+        (pending < SAVE_BATCH && currentTime - m_lastFlush < SAVE_INTERVAL_MS)) {
+        return;
+    }
+    m_flushing = true;
+    m_lastFlush = currentTime;
+    Terrain* terrain = mp_terrain.get();
+    // after the chunks streaming in, which the player is waiting for
+    JobHandle flush = mp_jobs->create([terrain]() {
+        terrain->flushSaves();
+    }, ChunkScheduler::loadRadius * 4.f);
+    JobHandle flushed = mp_jobs->create([this]() {
+        m_flushing = false;
+    }, 0.f, MAIN_LANE);
+    mp_jobs->depend(flushed, flush);
+    mp_jobs->submit(flush);
+    mp_jobs->submit(flushed);
+}
 
-    update();
+// submit a mesh job for the workers and an upload job for this thread,
+// both waiting for another job when one is given, return the upload job
+JobHandle MyGL::queueRemesh(sPtr<RemeshJob> remesh, float priority, JobHandle after) {
+    JobHandle mesh = mp_jobs->create([remesh]() {
+        remesh->mesh();
+    }, priority);
+    JobHandle upload = mp_jobs->create([remesh]() {
+        remesh->apply();
+    }, priority, MAIN_LANE);
+    if (after != nullptr) {
+        mp_jobs->depend(mesh, after);
+    }
+    mp_jobs->depend(upload, mesh);
+    mp_jobs->submit(mesh);
+    mp_jobs->submit(upload);
+    return upload;
 }
 
 void MyGL::updateWeather(int x, int z) {
@@ -318,16 +518,18 @@ bool MyGL::HerizCollisionDetect(glm::vec3 pos, glm::vec3 movetrend) {
     blockY = (int)(floorf(pos[1]));
     blockX = (int)(floorf(pos[0] + movetrend[0]));
     blockZ = (int)(floorf(pos[2] + movetrend[2]));
-    if (mp_terrain->getBlockAt(blockX, blockY, blockZ) != EMPTY) {
-        if (mp_terrain->getBlockAt(blockX, blockY, blockZ) == SNOW ||
-            mp_terrain->getBlockAt(blockX, blockY, blockZ) == LEAF ||
-            mp_terrain->getBlockAt(blockX, blockY, blockZ) == REDFLOWER ||
-            mp_terrain->getBlockAt(blockX, blockY, blockZ) == CROSSGRASS ||
-            mp_terrain->getBlockAt(blockX, blockY, blockZ) == MUSHROOM
+    BlockCursor cursor(mp_terrain.get(), blockX, blockZ);
+    BlockType block = cursor.getBlockAt(blockX, blockY, blockZ);
+    if (block != EMPTY) {
+        if (block == SNOW ||
+            block == LEAF ||
+            block == REDFLOWER ||
+            block == CROSSGRASS ||
+            block == MUSHROOM
                 ) {
             return false;
         }
-        if (mp_terrain->getBlockAt(blockX, blockY, blockZ) == WATER || mp_terrain->getBlockAt(blockX, blockY, blockZ) == LAVA) {
+        if (block == WATER || block == LAVA) {
             mp_player->status[mp_player->getIdSwim()] = true;
             return false;
         } else {
@@ -337,7 +539,7 @@ bool MyGL::HerizCollisionDetect(glm::vec3 pos, glm::vec3 movetrend) {
     }
     mp_player->status[mp_player->getIdSwim()] = false;
     blockY += 1;
-    if (mp_terrain->getBlockAt(blockX, blockY, blockZ) != EMPTY) {
+    if (cursor.getBlockAt(blockX, blockY, blockZ) != EMPTY) {
         return true;
     }
     return false;
@@ -348,26 +550,28 @@ bool MyGL::VertCollisionDetect(glm::vec3 pos, glm::vec3 movetrend) {
     blockY = (int)(floorf(pos[1] + movetrend[1]));
     blockX = (int)(floorf(pos[0]));
     blockZ = (int)(floorf(pos[2]));
+    BlockCursor cursor(mp_terrain.get(), blockX, blockZ);
 
     if (movetrend[1] > 0) { //if the character is rising, test its head but not bottom block
         if (mp_player->status[mp_player->getIdSwim()]) { // if the character is swimming
-            if (mp_terrain->getBlockAt(blockX, blockY, blockZ) == EMPTY) {
+            if (cursor.getBlockAt(blockX, blockY, blockZ) == EMPTY) {
                 mp_player->status[mp_player->getIdSwim()] = false; //swimming stops.
             }
         }
         blockY += 2;
     }
-    if (mp_terrain->getBlockAt(blockX, blockY, blockZ) != EMPTY) {
-        if (mp_terrain->getBlockAt(blockX, blockY, blockZ) == SNOW ||
-                mp_terrain->getBlockAt(blockX, blockY, blockZ) == LEAF ||
-                mp_terrain->getBlockAt(blockX, blockY, blockZ) == REDFLOWER ||
-                mp_terrain->getBlockAt(blockX, blockY, blockZ) == CROSSGRASS ||
-                mp_terrain->getBlockAt(blockX, blockY, blockZ) == MUSHROOM
+    BlockType block = cursor.getBlockAt(blockX, blockY, blockZ);
+    if (block != EMPTY) {
+        if (block == SNOW ||
+                block == LEAF ||
+                block == REDFLOWER ||
+                block == CROSSGRASS ||
+                block == MUSHROOM
                 ) {
             return false;
         }
         // next block is water or lava, begin swimming
-        if (mp_terrain->getBlockAt(blockX, blockY, blockZ) == WATER || mp_terrain->getBlockAt(blockX, blockY, blockZ) == LAVA) { //begin swimming
+        if (block == WATER || block == LAVA) { //begin swimming
             mp_player->status[mp_player->getIdSwim()] = true;
             return false;
         }
@@ -436,11 +640,13 @@ void MyGL::GLDrawScene()
     }
     mp_progSky->draw(*mp_geomQuad);
 
-    if (mp_terrain->getBlockAt(blockX, blockY, blockZ) == LAVA) {
+    // the block the camera is in tints the scene
+    BlockType eyeBlock = mp_terrain->getBlockAt(blockX, blockY, blockZ);
+    if (eyeBlock == LAVA) {
         mp_progLambert->setEnvironment(2);
         mp_progSky->setEnvironment(2);
         mp_progLambVC->setEnvironment(2);
-    } else if (mp_terrain->getBlockAt(blockX, blockY, blockZ) == WATER) {
+    } else if (eyeBlock == WATER) {
         mp_progLambert->setEnvironment(1);
         mp_progSky->setEnvironment(1);
         mp_progLambVC->setEnvironment(1);
@@ -456,9 +662,9 @@ void MyGL::GLDrawScene()
         mp_progLambert->setBlendType(2);
     }
 
-    for (auto it = terrain->m_chunks.begin(); it != terrain->m_chunks.end(); it++) {
+    for (Chunk& chunk : terrain->m_chunks) {
         mp_progLambert->setModelMatrix(glm::mat4());
-        mp_progLambert->draw(it->second, 0);
+        mp_progLambert->draw(chunk, 0);
     }
     for (unsigned int i = 0; i < mp_npcsystem->npcs.size(); i++) {
         NPC *npc = mp_npcsystem->npcs[i].get();
@@ -467,17 +673,17 @@ void MyGL::GLDrawScene()
             mp_progLambVC->draw(*(npc->partAt(j)), 0);
         }
     }
-    if (mp_terrain->getBlockAt(blockX, blockY, blockZ) == LAVA || mp_terrain->getBlockAt(blockX, blockY, blockZ) == WATER) {
+    if (eyeBlock == LAVA || eyeBlock == WATER) {
             glDisable(GL_CULL_FACE);
-            for (auto it = terrain->m_chunks.begin(); it != terrain->m_chunks.end(); it++) {
+            for (Chunk& chunk : terrain->m_chunks) {
                 mp_progLambert->setModelMatrix(glm::mat4());
-                mp_progLambert->draw(it->second, 1);
+                mp_progLambert->draw(chunk, 1);
             }
             glEnable(GL_CULL_FACE);
         } else {
-            for (auto it = terrain->m_chunks.begin(); it != terrain->m_chunks.end(); it++) {
+            for (Chunk& chunk : terrain->m_chunks) {
                 mp_progLambert->setModelMatrix(glm::mat4());
-                mp_progLambert->draw(it->second, 1);
+                mp_progLambert->draw(chunk, 1);
             }
         }
     for (auto it = terrain->m_rain.begin(); it != terrain->m_rain.end(); it++) {
@@ -512,6 +718,12 @@ void MyGL::keyPressEvent(QKeyEvent *e)
         } else {
             mp_camera->eye -= getThirdPersonDir();
         }
+    } else if (e->key() == Qt::Key_G) {
+        // switch between greedy and per-face meshing and rebuild all chunks
+        Chunk::greedyMeshing = !Chunk::greedyMeshing;
+        for (Chunk& chunk : mp_terrain->m_chunks) {
+            chunk.markAllDirty();
+        }
     }
     mp_player->KeyEventListener(e);
 }
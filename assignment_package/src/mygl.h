@@ -4,7 +4,7 @@
 #include <QOpenGLVertexArrayObject>
 #include <QOpenGLShaderProgram>
 #include <QDateTime>
-#include <QThreadPool>
+#include <map>
 
 #include "shaderprogram.h"
 #include "scene/npcsystem.h"
@@ -16,6 +16,8 @@
 #include "texture.h"
 #include "utils.h"
 #include "worker.h"
+#include "scene/chunkscheduler.h"
+#include "scene/blockcursor.h"
 
 class MyGL : public OpenGLContext
 {
@@ -45,6 +47,16 @@ private:
 //    uPtr<ThirdPerson> mp_thirdperson;
     uPtr<LSystem> mp_lsystem;
     uPtr<NPCSystem> mp_npcsystem;
+    // picks the missing chunks to load next
+    uPtr<ChunkScheduler> mp_scheduler;
+    // runs generation and meshing off this thread, declared after everything
+    // its jobs touch so its workers are joined first
+    uPtr<JobSystem> mp_jobs;
+    // chunks being generated or decorated, by chunk hash
+    std::map<int64_t, sPtr<StreamingChunk>> m_streaming;
+    // whether saved chunks are being written, and when the last write started
+    bool m_flushing;
+    int64_t m_lastFlush;
 
     uPtr<Texture> mp_texture;
     uPtr<Texture> mp_normalMap;
@@ -75,6 +87,19 @@ private:
     glm::vec3 getThirdPersonDir();
 
     void updateWeather(int x, int z);
+    // cancel the chunks streaming in that fell out of range and request new ones
+    void streamChunks();
+    // group the requested chunks that fill most of their 64 x 64 area, each group
+    // computes their biome maps in one pass, by the hash of the area with its job
+    void streamGroups(const std::vector<ChunkRequest> &requests,
+                      std::map<int64_t, sPtr<StreamingGroup>> &groups,
+                      std::map<int64_t, JobHandle> &jobs);
+    // unload a few chunks beyond the unload radius and the npcs on them,
+    // and write the saved chunks in batches
+    void unloadChunks();
+    // submit a mesh job for the workers and an upload job for this thread,
+    // both waiting for another job when one is given, return the upload job
+    JobHandle queueRemesh(sPtr<RemeshJob> remesh, float priority, JobHandle after = nullptr);
 
 public:
     explicit MyGL(QWidget *parent = 0);
@@ -7,13 +7,27 @@ noise::fbmParams Biome::frozenPars = noise::fbmParams();
 noise::fbmParams Biome::junglePars = noise::fbmParams();
 noise::fbmParams Biome::moisturePars = noise::fbmParams();
 noise::fbmParams Biome::temperaturePars = noise::fbmParams();
+ClimateField Biome::climate = ClimateField(moisturePars, temperaturePars);
+bool Biome::coarseClimate = false;
 
 Biome::Biome(int _x, int _z): x(_x), z(_z) {
-    moisture = noise::sealedFbm2D(x, z, moisturePars);
+    float moistureNoise, temperatureNoise;
+    climateAt(_x, _z, moistureNoise, temperatureNoise);
+    classify(moistureNoise, temperatureNoise);
+}
+
+// from the moisture and temperature noise of the column
+Biome::Biome(int _x, int _z, float moistureNoise, float temperatureNoise): x(_x), z(_z) {
+    classify(moistureNoise, temperatureNoise);
+}
+
+// the moisture, temperature and type from the moisture and temperature noise
+void Biome::classify(float moistureNoise, float temperatureNoise) {
+    moisture = moistureNoise;
     moisture /= moisturePars.scaleY;
     moisture *= 1.33;
     moisture = noise::clamp(moisture, 0.f, 1.f);
-    temperature = noise::sealedFbm2D(x, z, temperaturePars);
+    temperature = temperatureNoise;
     temperature /= temperaturePars.scaleY;
     temperature *= 1.33;
     temperature = noise::clamp(temperature, 0.f, 1.f);
@@ -39,16 +53,77 @@ BiomeType Biome::getBiome() const {
 }
 
 BiomeType Biome::getBiome(int &height) const {
-    int darkHeight = 129 + noise::sealedFbm2D(x, z, darkPars);
-    int desertHeight = 129 + noise::sealedFbm2D(x, z, desertPars);
-    int frozenHeight = 129 + noise::sealedFbm2D(x, z, frozenPars);
-    int jungleHeight = 129 + noise::sealedFbm2D(x, z, junglePars);
-    height = noise::mix(noise::mix(darkHeight, frozenHeight, moisture),
-                        noise::mix(desertHeight, jungleHeight, moisture),
-                        temperature);
+    height = blendHeight(noise::sealedFbm2D(x, z, darkPars),
+                         noise::sealedFbm2D(x, z, desertPars),
+                         noise::sealedFbm2D(x, z, frozenPars),
+                         noise::sealedFbm2D(x, z, junglePars));
     return type;
 }
 
+// blend the heights of the four landscapes by moisture and temperature
+int Biome::blendHeight(int darkNoise, int desertNoise, int frozenNoise, int jungleNoise) const {
+    int darkHeight = 129 + darkNoise;
+    int desertHeight = 129 + desertNoise;
+    int frozenHeight = 129 + frozenNoise;
+    int jungleHeight = 129 + jungleNoise;
+    return noise::mix(noise::mix(darkHeight, frozenHeight, moisture),
+                      noise::mix(desertHeight, jungleHeight, moisture),
+                      temperature);
+}
+
+// the biome types and heights of the w x h columns from (x0, z0), row by row along x,
+// the same as getBiome(height) of every column but with the noise evaluated in bulk,
+// also their moisture and temperature in [0, 1] when given
+void Biome::grid(int x0, int z0, int w, int h, BiomeType *types, int *heights,
+                 float *moistures, float *temperatures) {
+    int n = w * h;
+    std::vector<float> climateFields(2 * n);
+    float *moistureNoise = climateFields.data();
+    float *temperatureNoise = moistureNoise + n;
+    std::vector<int> fields(4 * n);
+    int *darkNoise = fields.data();
+    int *desertNoise = darkNoise + n;
+    int *frozenNoise = desertNoise + n;
+    int *jungleNoise = frozenNoise + n;
+    if (coarseClimate) {
+        climate.grid(x0, z0, w, h, moistureNoise, temperatureNoise);
+    } else {
+        std::vector<int> exact(2 * n);
+        noise::sealedFbmGrid(x0, z0, w, h, moisturePars, exact.data());
+        noise::sealedFbmGrid(x0, z0, w, h, temperaturePars, exact.data() + n);
+        std::copy(exact.begin(), exact.end(), climateFields.begin());
+    }
+    noise::sealedFbmGrid(x0, z0, w, h, darkPars, darkNoise);
+    noise::sealedFbmGrid(x0, z0, w, h, desertPars, desertNoise);
+    noise::sealedFbmGrid(x0, z0, w, h, frozenPars, frozenNoise);
+    noise::sealedFbmGrid(x0, z0, w, h, junglePars, jungleNoise);
+    for (int j = 0; j < h; j++) {
+        for (int i = 0; i < w; i++) {
+            int k = j * w + i;
+            Biome biome(x0 + i, z0 + j, moistureNoise[k], temperatureNoise[k]);
+            types[k] = biome.type;
+            heights[k] = biome.blendHeight(darkNoise[k], desertNoise[k],
+                                           frozenNoise[k], jungleNoise[k]);
+            if (moistures != nullptr) {
+                moistures[k] = biome.moisture;
+            }
+            if (temperatures != nullptr) {
+                temperatures[k] = biome.temperature;
+            }
+        }
+    }
+}
+
+// the moisture and temperature noise of a column
+void Biome::climateAt(int x, int z, float &moistureNoise, float &temperatureNoise) {
+    if (coarseClimate) {
+        climate.sample(x, z, moistureNoise, temperatureNoise);
+    } else {
+        moistureNoise = noise::sealedFbm2D(x, z, moisturePars);
+        temperatureNoise = noise::sealedFbm2D(x, z, temperaturePars);
+    }
+}
+
 void Biome::InitializeParams() {
     darkPars.exponent = 3;
     darkPars.scaleY = 60.f;
@@ -1,6 +1,7 @@
 #ifndef BIOME_H
 #define BIOME_H
 #include "noise.h"
+#include "climatefield.h"
 
 enum BiomeType : unsigned char
 {
@@ -9,6 +10,8 @@ enum BiomeType : unsigned char
 
 class Biome
 {
+    // checks the coarse climate against the exact one
+    friend class ClimateTest;
 private:
     int x;
     int z;
@@ -22,12 +25,33 @@ private:
     static noise::fbmParams junglePars;
     static noise::fbmParams moisturePars;
     static noise::fbmParams temperaturePars;
+private:
+    // the moisture and temperature noise of the climate, interpolated between
+    // coarse samples when coarseClimate is set
+    static ClimateField climate;
+private:
+    // from the moisture and temperature noise of the column
+    Biome(int _x, int _z, float moistureNoise, float temperatureNoise);
+    // the moisture, temperature and type from the moisture and temperature noise
+    void classify(float moistureNoise, float temperatureNoise);
+    // blend the heights of the four landscapes by moisture and temperature
+    int blendHeight(int darkNoise, int desertNoise, int frozenNoise, int jungleNoise) const;
 public:
     Biome(int _x, int _z);
     BiomeType getBiome() const;
     BiomeType getBiome(int &height) const;
 public:
+    // take the climate from the coarse samples instead of evaluating it at every column,
+    // set for new worlds only, the biomes of old ones would shift a little
+    static bool coarseClimate;
     static void InitializeParams();
+    // the moisture and temperature noise of a column
+    static void climateAt(int x, int z, float &moistureNoise, float &temperatureNoise);
+    // the biome types and heights of the w x h columns from (x0, z0), row by row along x,
+    // the same as getBiome(height) of every column but with the noise evaluated in bulk,
+    // also their moisture and temperature in [0, 1] when given
+    static void grid(int x0, int z0, int w, int h, BiomeType *types, int *heights,
+                     float *moistures = nullptr, float *temperatures = nullptr);
 };
 
 #endif // BIOME_H
@@ -0,0 +1,43 @@
+#include "biomemap.h"
+#include <algorithm>
+#include <vector>
+
+BiomeMap::BiomeMap() {
+    std::fill(m_types, m_types + 16 * 16, PLAIN);
+    std::fill(m_moistures, m_moistures + 16 * 16, 0.f);
+    std::fill(m_temperatures, m_temperatures + 16 * 16, 0.f);
+    std::fill(m_heights, m_heights + 16 * 16, 0);
+}
+
+// compute the columns of the chunk at a chunk origin
+void BiomeMap::build(int x0, int z0) {
+    int heights[16 * 16];
+    Biome::grid(x0, z0, 16, 16, m_types, heights, m_moistures, m_temperatures);
+    std::copy(heights, heights + 16 * 16, m_heights);
+}
+
+// compute the maps of a block of chunksX x chunksZ chunks from a chunk origin
+// in one pass, sharing the noise samples across chunk borders,
+// maps holds one map per chunk, row by row along x
+void BiomeMap::buildGroup(int x0, int z0, int chunksX, int chunksZ, BiomeMap *maps) {
+    int w = chunksX * 16;
+    int h = chunksZ * 16;
+    int n = w * h;
+    std::vector<BiomeType> types(n);
+    std::vector<int> heights(n);
+    std::vector<float> climate(2 * n);
+    Biome::grid(x0, z0, w, h, types.data(), heights.data(), climate.data(), climate.data() + n);
+    for (int cz = 0; cz < chunksZ; cz++) {
+        for (int cx = 0; cx < chunksX; cx++) {
+            BiomeMap &map = maps[cz * chunksX + cx];
+            for (int z = 0; z < 16; z++) {
+                int k = (cz * 16 + z) * w + cx * 16;
+                std::copy(types.begin() + k, types.begin() + k + 16, map.m_types + z * 16);
+                std::copy(heights.begin() + k, heights.begin() + k + 16, map.m_heights + z * 16);
+                std::copy(climate.begin() + k, climate.begin() + k + 16, map.m_moistures + z * 16);
+                std::copy(climate.begin() + n + k, climate.begin() + n + k + 16,
+                          map.m_temperatures + z * 16);
+            }
+        }
+    }
+}
@@ -0,0 +1,49 @@
+#ifndef BIOMEMAP_H
+#define BIOMEMAP_H
+
+#include "biome.h"
+
+// the biome of every column of a chunk, computed once when the chunk is
+// generated or loaded so later lookups evaluate no noise
+class BiomeMap
+{
+private:
+    BiomeType m_types[16 * 16];
+    // moisture and temperature in [0, 1]
+    float m_moistures[16 * 16];
+    float m_temperatures[16 * 16];
+    // the height of the landscape before lakes and dunes are carved into it
+    short m_heights[16 * 16];
+
+public:
+    BiomeMap();
+    // compute the columns of the chunk at a chunk origin
+    void build(int x0, int z0);
+    // compute the maps of a block of chunksX x chunksZ chunks from a chunk origin
+    // in one pass, sharing the noise samples across chunk borders,
+    // maps holds one map per chunk, row by row along x
+    static void buildGroup(int x0, int z0, int chunksX, int chunksZ, BiomeMap *maps);
+    // lookups by chunk-local column
+    BiomeType typeAt(int x, int z) const;
+    float moistureAt(int x, int z) const;
+    float temperatureAt(int x, int z) const;
+    int heightAt(int x, int z) const;
+};
+
+inline BiomeType BiomeMap::typeAt(int x, int z) const {
+    return m_types[x + z * 16];
+}
+
+inline float BiomeMap::moistureAt(int x, int z) const {
+    return m_moistures[x + z * 16];
+}
+
+inline float BiomeMap::temperatureAt(int x, int z) const {
+    return m_temperatures[x + z * 16];
+}
+
+inline int BiomeMap::heightAt(int x, int z) const {
+    return m_heights[x + z * 16];
+}
+
+#endif // BIOMEMAP_H
@@ -0,0 +1,65 @@
+#include "blockcursor.h"
+
+// a chunk origin is a multiple of 16, so the first query always looks up its chunk
+BlockCursor::BlockCursor(Terrain* terrain) :
+    mp_terrain(terrain), m_x(1), m_z(1), mp_chunk(nullptr)
+{}
+
+// start on the chunk holding a world-space column
+BlockCursor::BlockCursor(Terrain* terrain, int x, int z) :
+    BlockCursor(terrain)
+{
+    moveTo(x, z);
+}
+
+// move onto the chunk holding a world-space column
+void BlockCursor::moveTo(int x, int z) {
+    int xo = x & -16;
+    int zo = z & -16;
+    if (xo == m_x && zo == m_z) {
+        return;
+    }
+    // the links of a loaded chunk are null exactly when that neighbor is not loaded
+    Chunk* next = nullptr;
+    bool linked = mp_chunk != nullptr;
+    if (linked && zo == m_z && xo == m_x - 16) {
+        next = mp_chunk->left;
+    } else if (linked && zo == m_z && xo == m_x + 16) {
+        next = mp_chunk->right;
+    } else if (linked && xo == m_x && zo == m_z - 16) {
+        next = mp_chunk->back;
+    } else if (linked && xo == m_x && zo == m_z + 16) {
+        next = mp_chunk->front;
+    } else {
+        next = mp_terrain->m_chunks.find(mp_terrain->hash(xo, zo));
+    }
+    m_x = xo;
+    m_z = zo;
+    mp_chunk = next;
+}
+
+// get the blocktypes at a number of world-space positions
+void BlockCursor::getBlocks(const glm::ivec3* positions, int count, BlockType* blocks) {
+    for (int i = 0; i < count; i++) {
+        blocks[i] = getBlockAt(positions[i].x, positions[i].y, positions[i].z);
+    }
+}
+
+// set the blocktype at a world-space position like Terrain::setBlockAt
+// when there is no chunk, do nothing
+void BlockCursor::setBlockAt(int x, int y, int z, BlockType t) {
+    moveTo(x, z);
+    if (mp_chunk == nullptr) {
+        return;
+    }
+    mp_terrain->setBlockIn(*mp_chunk, x, y, z, t);
+}
+
+// fill the blocks y0 <= y < y1 of a world-space column like Terrain::fillColumn
+void BlockCursor::fillColumn(int x, int z, int y0, int y1, BlockType t) {
+    moveTo(x, z);
+    if (mp_chunk == nullptr) {
+        return;
+    }
+    mp_terrain->fillColumnIn(*mp_chunk, x, z, y0, y1, t);
+}
@@ -0,0 +1,53 @@
+#ifndef BLOCKCURSOR_H
+#define BLOCKCURSOR_H
+
+#include "terrain.h"
+
+// reads and writes blocks of the terrain around a spot, remembering the chunk it
+// last touched, so queries close together skip the chunk lookup, and a step onto
+// an adjacent chunk follows the neighbor links instead of the chunk map,
+// it holds a plain chunk pointer, so keep it only as long as no chunk is unloaded
+class BlockCursor
+{
+private:
+    Terrain* mp_terrain;
+    // origin of the chunk the cursor is on
+    int m_x;
+    int m_z;
+    // the chunk there, nullptr when it is not loaded
+    Chunk* mp_chunk;
+
+public:
+    explicit BlockCursor(Terrain* terrain);
+    // start on the chunk holding a world-space column
+    BlockCursor(Terrain* terrain, int x, int z);
+
+    // move onto the chunk holding a world-space column
+    void moveTo(int x, int z);
+    // find if there is a chunk at a world-space column
+    bool hasChunk(int x, int z) {
+        moveTo(x, z);
+        return mp_chunk != nullptr;
+    }
+    // get the blocktype at a world-space position
+    // return empty when no block is there or it is above or below the world
+    BlockType getBlockAt(int x, int y, int z) {
+        if (y < 0 || y > 255) {
+            return EMPTY;
+        }
+        moveTo(x, z);
+        if (mp_chunk == nullptr) {
+            return EMPTY;
+        }
+        return static_cast<const Chunk*>(mp_chunk)->blockAt(x - m_x, y, z - m_z);
+    }
+    // get the blocktypes at a number of world-space positions
+    void getBlocks(const glm::ivec3* positions, int count, BlockType* blocks);
+    // set the blocktype at a world-space position like Terrain::setBlockAt
+    // when there is no chunk, do nothing
+    void setBlockAt(int x, int y, int z, BlockType t);
+    // fill the blocks y0 <= y < y1 of a world-space column like Terrain::fillColumn
+    void fillColumn(int x, int z, int y0, int y1, BlockType t);
+};
+
+#endif // BLOCKCURSOR_H
@@ -0,0 +1,179 @@
+#include "blocksection.h"
+#include "chunk.h"
+#include <algorithm>
+
+static const int SECTION_SIZE = 16 * 16 * 16;
+
+BlockSection::BlockSection() :
+    m_palette(1, EMPTY), m_counts(1, SECTION_SIZE), m_indices(), m_bits(0) {}
+
+void BlockSection::setPaletteIndex(int index, int p) {
+    int bit = index * m_bits;
+    uint64_t mask = (uint64_t((1u << m_bits) - 1)) << (bit & 63);
+    uint64_t& word = m_indices[bit >> 6];
+    word = (word & ~mask) | (uint64_t(p) << (bit & 63));
+}
+
+void BlockSection::set(int index, BlockType type) {
+    int old = m_bits == 0 ? 0 : paletteIndex(index);
+    if (m_palette[old] == type) {
+        return;
+    }
+    int p = paletteEntry(type);
+    setPaletteIndex(index, p);
+    m_counts[old]--;
+    m_counts[p]++;
+    collapse(p);
+}
+
+// set count blocks, starting at index and stepping by stride, resolving the
+// palette entry once, a uniform section of the same type is left untouched
+void BlockSection::fill(int index, int stride, int count, BlockType type) {
+    if (m_bits == 0 && m_palette[0] == type) {
+        return;
+    }
+    if (count == SECTION_SIZE && stride == 1) {
+        fill(type);
+        return;
+    }
+    int p = paletteEntry(type);
+    for (int i = 0; i < count; i++, index += stride) {
+        int old = paletteIndex(index);
+        if (old != p) {
+            setPaletteIndex(index, p);
+            m_counts[old]--;
+            m_counts[p]++;
+        }
+    }
+    collapse(p);
+}
+
+// fill the whole section with a single type
+void BlockSection::fill(BlockType type) {
+    m_palette.assign(1, type);
+    m_counts.assign(1, SECTION_SIZE);
+    std::vector<uint64_t>().swap(m_indices);
+    m_bits = 0;
+}
+
+// the palette entry of a type, added when missing, widening the indices if needed
+int BlockSection::paletteEntry(BlockType type) {
+    int p = std::find(m_palette.begin(), m_palette.end(), type) - m_palette.begin();
+    if (p == int(m_palette.size())) {
+        // reuse the entry of a type no block uses anymore
+        p = std::find(m_counts.begin(), m_counts.end(), 0) - m_counts.begin();
+        if (p < int(m_palette.size())) {
+            m_palette[p] = type;
+        } else {
+            if (m_palette.size() >= (1u << m_bits)) {
+                grow();
+            }
+            m_palette.push_back(type);
+            m_counts.push_back(0);
+        }
+    }
+    return p;
+}
+
+// back to a single type, drop the indices
+void BlockSection::collapse(int p) {
+    if (m_counts[p] == SECTION_SIZE) {
+        fill(m_palette[p]);
+    }
+}
+
+void BlockSection::grow() {
+    int bits = m_bits == 0 ? 1 : m_bits * 2;
+    std::vector<uint64_t> indices(SECTION_SIZE * bits / 64, 0);
+    if (m_bits > 0) {
+        for (int i = 0; i < SECTION_SIZE; i++) {
+            uint64_t p = paletteIndex(i);
+            int bit = i * bits;
+            indices[bit >> 6] |= p << (bit & 63);
+        }
+    }
+    m_indices.swap(indices);
+    m_bits = bits;
+}
+
+bool BlockSection::isUniform() const {
+    return m_bits == 0;
+}
+
+size_t BlockSection::byteSize() const {
+    return sizeof(BlockSection) + m_palette.capacity() * sizeof(BlockType) +
+            m_counts.capacity() * sizeof(uint16_t) +
+            m_indices.capacity() * sizeof(uint64_t);
+}
+
+// append the palette and indices to a byte buffer
+// bits (1 byte) | palette size (2 bytes) | palette | indices as little-endian words
+void BlockSection::write(std::vector<uint8_t> &out) const {
+    out.push_back(uint8_t(m_bits));
+    out.push_back(uint8_t(m_palette.size() & 0xff));
+    out.push_back(uint8_t(m_palette.size() >> 8));
+    for (BlockType type : m_palette) {
+        out.push_back(uint8_t(type));
+    }
+    for (uint64_t word : m_indices) {
+        for (int i = 0; i < 64; i += 8) {
+            out.push_back(uint8_t(word >> i));
+        }
+    }
+}
+
+// read what write appended and advance data past it,
+// return false and keep this section unchanged when the bytes are invalid
+bool BlockSection::read(const uint8_t *&data, const uint8_t *end) {
+    if (end - data < 3) {
+        return false;
+    }
+    int bits = data[0];
+    size_t paletteSize = data[1] | (data[2] << 8);
+    if ((bits != 0 && bits != 1 && bits != 2 && bits != 4 && bits != 8) ||
+        paletteSize == 0 || paletteSize > (1u << bits)) {
+        return false;
+    }
+    size_t words = SECTION_SIZE * bits / 64;
+    if (size_t(end - data) < 3 + paletteSize + words * 8) {
+        return false;
+    }
+    const uint8_t *p = data + 3;
+    std::vector<BlockType> palette(paletteSize);
+    for (size_t i = 0; i < paletteSize; i++) {
+        if (p[i] > CLOUD) {
+            return false;
+        }
+        palette[i] = BlockType(p[i]);
+    }
+    p += paletteSize;
+    std::vector<uint64_t> indices(words);
+    for (size_t w = 0; w < words; w++) {
+        uint64_t word = 0;
+        for (int i = 0; i < 8; i++) {
+            word |= uint64_t(p[i]) << (i * 8);
+        }
+        indices[w] = word;
+        p += 8;
+    }
+    // count the blocks of every palette entry, which also checks the indices
+    std::vector<uint16_t> counts(paletteSize, 0);
+    if (bits == 0) {
+        counts[0] = SECTION_SIZE;
+    } else {
+        for (int i = 0; i < SECTION_SIZE; i++) {
+            int bit = i * bits;
+            size_t index = (indices[bit >> 6] >> (bit & 63)) & ((1u << bits) - 1);
+            if (index >= paletteSize) {
+                return false;
+            }
+            counts[index]++;
+        }
+    }
+    m_palette.swap(palette);
+    m_counts.swap(counts);
+    m_indices.swap(indices);
+    m_bits = bits;
+    data = p;
+    return true;
+}
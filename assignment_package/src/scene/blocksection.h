@@ -0,0 +1,69 @@
+#ifndef BLOCKSECTION_H
+#define BLOCKSECTION_H
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// defined in chunk.h
+enum BlockType : unsigned char;
+
+// palette-compressed blocks of a 16 x 16 x 16 section of a chunk,
+// every block stores an index into the palette of the distinct types
+// in the section, using 0, 1, 2, 4 or 8 bits per block,
+// so a section of a single type (air, stone) stores no indices at all
+// and drops them again once edits leave a single type behind
+class BlockSection
+{
+private:
+    // the distinct block types in this section
+    std::vector<BlockType> m_palette;
+    // number of blocks using each palette entry
+    std::vector<uint16_t> m_counts;
+    // bit-packed palette indices, empty while the section is uniform
+    std::vector<uint64_t> m_indices;
+    // bits per palette index
+    int m_bits;
+
+    int paletteIndex(int index) const;
+    void setPaletteIndex(int index, int p);
+    // widen the indices to make room for more palette entries
+    void grow();
+    // the palette entry of a type, added when missing
+    int paletteEntry(BlockType type);
+    // drop the indices once every block uses palette entry p
+    void collapse(int p);
+
+public:
+    // a section filled with EMPTY
+    BlockSection();
+    // index = x + y * 16 + z * 256 inside the section
+    BlockType get(int index) const;
+    void set(int index, BlockType type);
+    // set count blocks, starting at index and stepping by stride
+    void fill(int index, int stride, int count, BlockType type);
+    // fill the whole section with a single type
+    void fill(BlockType type);
+    // filled with a single block type
+    bool isUniform() const;
+    // bytes used by the palette and indices
+    size_t byteSize() const;
+    // append the palette and indices to a byte buffer
+    void write(std::vector<uint8_t> &out) const;
+    // read what write appended and advance data past it,
+    // return false and keep this section unchanged when the bytes are invalid
+    bool read(const uint8_t *&data, const uint8_t *end);
+};
+
+inline int BlockSection::paletteIndex(int index) const {
+    int bit = index * m_bits;
+    return (m_indices[bit >> 6] >> (bit & 63)) & ((1u << m_bits) - 1);
+}
+
+inline BlockType BlockSection::get(int index) const {
+    if (m_bits == 0) {
+        return m_palette[0];
+    }
+    return m_palette[paletteIndex(index)];
+}
+
+#endif // BLOCKSECTION_H
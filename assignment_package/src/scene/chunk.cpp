@@ -1,4 +1,143 @@
 #include "chunk.h"
+#include "faceculling.h"
+#include "chunksnapshot.h"
+#include <chrono>
+#include <iostream>
+
+bool Chunk::greedyMeshing = true;
+bool Chunk::bitmaskCulling = true;
+int Chunk::deltaMaxEdits = 1024;
+
+// everything the mesher knows about a block type, listed in BlockType order
+struct BlockDef
+{
+    BlockType type;
+    // atlas tile of the top face and of every other face
+    unsigned char topX, topY;
+    unsigned char sideX, sideY;
+    // cosine palette and animation, see lambert.frag.glsl
+    unsigned char cosine;
+    unsigned char animated;
+    bool textured;
+    bool opaque;
+    bool collidable;
+    // drawn as two crossing quads
+    bool cross;
+};
+
+static constexpr BlockDef blockDefs[] = {
+    //               top      side     cos anim tex    opaque collide cross
+    {EMPTY,          0,  0,   0,  0,   0,  0,   true,  false, false,  false},
+    {GRASS,          8,  13,  3,  15,  5,  0,   true,  true,  true,   false},
+    {DIRT,           2,  15,  2,  15,  5,  0,   true,  true,  true,   false},
+    {STONE,          1,  15,  1,  15,  3,  0,   true,  true,  true,   false},
+    {LAVA,           14, 1,   14, 1,   8,  1,   true,  false, true,   false},
+    {WATER,          14, 3,   14, 3,   8,  1,   true,  false, false,  false},
+    {SNOW,           2,  11,  4,  11,  5,  0,   true,  true,  true,   false},
+    {BEDROCK,        1,  14,  1,  14,  3,  0,   true,  true,  true,   false},
+    {WOOD,           5,  14,  4,  14,  5,  0,   true,  true,  true,   false},
+    {LEAF,           5,  12,  5,  12,  5,  10,  true,  true,  true,   false},
+    {ICE,            3,  11,  3,  11,  3,  0,   true,  false, true,   false},
+    {REDFLOWER,      12, 15,  12, 15,  5,  0,   true,  false, false,  true},
+    {CROSSGRASS,     7,  13,  7,  13,  5,  0,   true,  false, false,  true},
+    {MUSHROOM,       12, 14,  12, 14,  5,  0,   true,  false, false,  true},
+    {LAKEBOTTOM,     2,  14,  2,  14,  3,  0,   true,  true,  true,   false},
+    {SAND,           0,  4,   0,  4,   5,  0,   true,  true,  true,   false},
+    {EVIL,           5,  13,  5,  13,  5,  0,   true,  true,  true,   false},
+    {LEAFMOLD,       4,  12,  4,  12,  5,  0,   true,  true,  true,   false},
+    {FROZEDIRT,      14, 11,  13, 11,  5,  0,   true,  true,  true,   false},
+    {GREYMUSHROOM,   13, 14,  13, 14,  5,  0,   true,  false, false,  true},
+    {BUSH,           15, 12,  15, 12,  5,  0,   true,  false, false,  true},
+    {DEADBRANCH,     7,  12,  7,  12,  5,  0,   true,  false, false,  true},
+    {GOLD,           0,  13,  0,  13,  3,  0,   true,  true,  true,   false},
+    {COAL,           2,  13,  2,  13,  3,  0,   true,  true,  true,   false},
+    {RUBY,           3,  12,  3,  12,  3,  0,   true,  true,  true,   false},
+    {YELLOWROCK,     2,  5,   2,  5,   5,  0,   true,  true,  true,   false},
+    {ORANGEROCK,     2,  2,   2,  2,   5,  0,   true,  true,  true,   false},
+    {REDROCK,        1,  7,   1,  7,   5,  0,   true,  true,  true,   false},
+    {CLOUD,          0,  0,   0,  0,   8,  9,   false, false, false,  false}
+};
+
+static constexpr int BLOCK_TYPES = sizeof(blockDefs) / sizeof(BlockDef);
+
+static constexpr bool blockDefsInOrder() {
+    for (int i = 0; i < BLOCK_TYPES; i++) {
+        if (blockDefs[i].type != i) {
+            return false;
+        }
+    }
+    return true;
+}
+static_assert(BLOCK_TYPES == CLOUD + 1 && blockDefsInOrder(),
+              "blockDefs needs one entry per BlockType, in order");
+
+// the packed material word of every face of every block type, see CHUNK_VERTEX_WORDS
+struct MaterialTable
+{
+    GLuint words[BLOCK_TYPES][6];
+};
+
+static constexpr MaterialTable buildMaterials() {
+    MaterialTable table = {};
+    for (int type = 0; type < BLOCK_TYPES; type++) {
+        const BlockDef& def = blockDefs[type];
+        for (int face = 0; face < 6; face++) {
+            GLuint x = face == TOP ? def.topX : def.sideX;
+            GLuint y = face == TOP ? def.topY : def.sideY;
+            table.words[type][face] = x | (y << 4) | (def.cosine << 8) | (def.animated << 12) |
+                                      (def.cross ? 1 << 16 : 0) | (def.textured ? 0 : 1 << 17);
+        }
+    }
+    return table;
+}
+
+static constexpr MaterialTable materials = buildMaterials();
+
+// unit corners of every face, indexed by FaceType, in the winding that keeps the
+// orientation and uv layout, crossing decals use the same corners and are moved
+// half a block inwards by the shader
+static constexpr int faceCorners[6][4][3] = {
+    // LEFT
+    {{0, 0, 0}, {0, 0, 1}, {0, 1, 1}, {0, 1, 0}},
+    // RIGHT
+    {{1, 0, 1}, {1, 0, 0}, {1, 1, 0}, {1, 1, 1}},
+    // FRONT
+    {{0, 0, 1}, {1, 0, 1}, {1, 1, 1}, {0, 1, 1}},
+    // BACK
+    {{1, 0, 0}, {0, 0, 0}, {0, 1, 0}, {1, 1, 0}},
+    // TOP
+    {{0, 1, 1}, {1, 1, 1}, {1, 1, 0}, {0, 1, 0}},
+    // BOTTOM
+    {{0, 0, 0}, {1, 0, 0}, {1, 0, 1}, {0, 0, 1}}
+};
+
+// the axis along the normal of every face, indexed by FaceType,
+// a face spans the next two axes, (d + 1) % 3 and (d + 2) % 3
+static constexpr int faceAxis[6] = {0, 0, 2, 2, 1, 1};
+
+// block offset to the neighbor behind every face, indexed by FaceType
+static constexpr int faceSteps[6][3] = {
+    {-1, 0, 0}, {1, 0, 0}, {0, 0, 1}, {0, 0, -1}, {0, 1, 0}, {0, -1, 0}
+};
+
+// the order visitBlocks emits the faces of a block in
+static constexpr FaceType blockFaces[6] = {LEFT, RIGHT, BOTTOM, TOP, BACK, FRONT};
+static constexpr FaceType crossFaces[4] = {FRONT, RIGHT, BACK, LEFT};
+
+// quads reserved up front in the scratch buffers of a meshing thread
+static const int SCRATCH_QUADS = 4096;
+
+// faces are appended to buffers owned by the meshing thread, which keep their
+// capacity from one section to the next, and the result is copied out at its final size
+static SectionMesh& scratchMesh() {
+    static thread_local SectionMesh mesh;
+    if (mesh.opaque.capacity() == 0) {
+        mesh.opaque.reserve(SCRATCH_QUADS * 4 * CHUNK_VERTEX_WORDS);
+        mesh.transparency.reserve(SCRATCH_QUADS * 4 * CHUNK_VERTEX_WORDS);
+    }
+    mesh.clear();
+    return mesh;
+}
 
 // openGL create
 void Chunk::create() {
@@ -12,616 +151,782 @@ void Chunk::create(const ChunkCreateInfo *info) {
     if (info == nullptr) {
         return;
     }
+    uploadMeshes(info, (1 << CHUNK_SECTIONS) - 1, (1 << CHUNK_EDGES) - 1);
+}
+
+// upload the meshes of the given sections and edges of a create info,
+// the others stay as they are on the gpu
+void Chunk::uploadMeshes(const ChunkCreateInfo *info, uint16_t sections, uint8_t edges) {
+    m_meshed = true;
+    const std::vector<GLuint>* opaque[CHUNK_MESHES];
+    const std::vector<GLuint>* transparency[CHUNK_MESHES];
+    for (int i = 0; i < CHUNK_MESHES; i++) {
+        const SectionMesh& mesh = i < CHUNK_SECTIONS ? info->sections[i] :
+                                                       info->edges[i - CHUNK_SECTIONS];
+        bool replaced = i < CHUNK_SECTIONS ? (sections & (1 << i)) :
+                                             (edges & (1 << (i - CHUNK_SECTIONS)));
+        opaque[i] = replaced ? &mesh.opaque : nullptr;
+        transparency[i] = replaced ? &mesh.transparency : nullptr;
+    }
 
-    count0 = info->idx0.size();
-    count1 = info->idx1.size();
     // Opaque pass
-    // Create a VBO on our GPU and store its handle in bufIdx
-    generateIdx0();
-    // Tell OpenGL that we want to perform subsequent operations on the VBO referred to by bufIdx
-    // and that it will be treated as an element array buffer (since it will contain triangle indices)
-    context->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, bufIdx0);
-    // Pass the data stored in cyl_idx into the bound buffer, reading a number of bytes equal to
-    // SPH_IDX_COUNT multiplied by the size of a GLuint. This data is sent to the GPU to be read by shader programs.
-    context->glBufferData(GL_ELEMENT_ARRAY_BUFFER, info->idx0.size() * sizeof(GLuint), info->idx0.data(), GL_STATIC_DRAW);
-
-    // The next few sets of function calls are basically the same as above, except bufPos and bufNor are
-    // array buffers rather than element array buffers, as they store vertex attributes like position.
-    generateVer0();
-    context->glBindBuffer(GL_ARRAY_BUFFER, bufVer0);
-    context->glBufferData(GL_ARRAY_BUFFER, info->opaque.size() * sizeof(float), info->opaque.data(), GL_STATIC_DRAW);
+    // Every face is a quad, so indices come from the buffer shared by all drawables
+    bufVer0 = spliceBuffer(bufVer0, verBound0, m_opaqueWords, opaque);
+    verBound0 = true;
+    int words0 = 0;
+    for (uint32_t words : m_opaqueWords) {
+        words0 += words;
+    }
+    useSharedQuadIdx0(words0 / (4 * CHUNK_VERTEX_WORDS));
 
     // Transparent pass
-    // Create a VBO on our GPU and store its handle in bufIdx
+    bufVer1 = spliceBuffer(bufVer1, verBound1, m_transparentWords, transparency);
+    verBound1 = true;
+    int words1 = 0;
+    for (uint32_t words : m_transparentWords) {
+        words1 += words;
+    }
+    useSharedQuadIdx1(words1 / (4 * CHUNK_VERTEX_WORDS));
+}
+
+// a new vbo of every mesh of one pass, uploading the replaced ones, those that are
+// not null, and copying the others on the gpu from the old vbo, updates words
+GLuint Chunk::spliceBuffer(GLuint old, bool hasOld, uint32_t *words,
+                           const std::vector<GLuint> *const *replaced) {
+    uint32_t oldOffsets[CHUNK_MESHES];
+    uint32_t total = 0;
+    for (int i = 0; i < CHUNK_MESHES; i++) {
+        oldOffsets[i] = total;
+        total += words[i];
+    }
+    uint32_t newTotal = 0;
+    for (int i = 0; i < CHUNK_MESHES; i++) {
+        newTotal += replaced[i] != nullptr ? (uint32_t)replaced[i]->size() : words[i];
+    }
+    GLuint buffer;
+    context->glGenBuffers(1, &buffer);
+    context->glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    context->glBufferData(GL_COPY_WRITE_BUFFER, newTotal * sizeof(GLuint), nullptr, GL_STATIC_DRAW);
+    if (hasOld) {
+        context->glBindBuffer(GL_COPY_READ_BUFFER, old);
+    }
+    size_t offset = 0;
+    for (int i = 0; i < CHUNK_MESHES; i++) {
+        if (replaced[i] != nullptr) {
+            words[i] = (uint32_t)replaced[i]->size();
+            if (words[i] > 0) {
+                context->glBufferSubData(GL_COPY_WRITE_BUFFER, offset * sizeof(GLuint),
+                                         words[i] * sizeof(GLuint), replaced[i]->data());
+            }
+        } else if (words[i] > 0 && hasOld) {
+            context->glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+                                         oldOffsets[i] * sizeof(GLuint), offset * sizeof(GLuint),
+                                         words[i] * sizeof(GLuint));
+        }
+        offset += words[i];
+    }
+    if (hasOld) {
+        context->glDeleteBuffers(1, &old);
+    }
+    return buffer;
+}
 
-    if (info->idx1.size() > 0) {
-        generateIdx1();
-        // Tell OpenGL that we want to perform subsequent operations on the VBO referred to by bufIdx
-        // and that it will be treated as an element array buffer (since it will contain triangle indices)
-        context->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, bufIdx1);
-        // Pass the data stored in cyl_idx into the bound buffer, reading a number of bytes equal to
-        // SPH_IDX_COUNT multiplied by the size of a GLuint. This data is sent to the GPU to be read by shader programs.
-        context->glBufferData(GL_ELEMENT_ARRAY_BUFFER, info->idx1.size() * sizeof(GLuint), info->idx1.data(), GL_STATIC_DRAW);
+// empty the mesh but keep its buffers
+void SectionMesh::clear() {
+    quads0 = 0;
+    quads1 = 0;
+    opaque.clear();
+    transparency.clear();
+}
 
-        // The next few sets of function calls are basically the same as above, except bufPos and bufNor are
-        // array buffers rather than element array buffers, as they store vertex attributes like position.
-        generateVer1();
-        context->glBindBuffer(GL_ARRAY_BUFFER, bufVer1);
-        context->glBufferData(GL_ARRAY_BUFFER, info->transparency.size() * sizeof(float), info->transparency.data(), GL_STATIC_DRAW);
+int ChunkCreateInfo::quads0() const {
+    int quads = 0;
+    for (const SectionMesh& mesh : sections) {
+        quads += mesh.quads0;
+    }
+    for (const SectionMesh& mesh : edges) {
+        quads += mesh.quads0;
     }
+    return quads;
 }
 
-// populate and create this and all neighbors
-void Chunk::combinedCreate() {
-    ChunkCreateInfo info;
-    ChunkCreateInfo li;
-    ChunkCreateInfo ri;
-    ChunkCreateInfo fi;
-    ChunkCreateInfo bi;
-    populateInfo(&info);
-    populateNeighbor(&li, &ri, &fi, &bi);
-    updateSelf(&info);
-    updateNeighbor(&li, &ri, &fi, &bi);
+int ChunkCreateInfo::quads1() const {
+    int quads = 0;
+    for (const SectionMesh& mesh : sections) {
+        quads += mesh.quads1;
+    }
+    for (const SectionMesh& mesh : edges) {
+        quads += mesh.quads1;
+    }
+    return quads;
+}
+
+bool Chunk::isPacked() {
+    return true;
+}
+
+glm::vec4 Chunk::packedOrigin() {
+    return m_originPos;
 }
 
-// populate chunk create info
+// populate chunk create info from the blocks of the chunk and its current neighbors
 void Chunk::populateInfo(ChunkCreateInfo *info) const {
-    createCubes(info->opaque, info->transparency, info->idx0, info->idx1);
+    ChunkSnapshot blocks;
+    blocks.capture(*this);
+    populateInfo(blocks, info);
 }
 
-// populate chunk create info of neighbors
-void Chunk::populateNeighbor(ChunkCreateInfo *li, ChunkCreateInfo *ri,
-                             ChunkCreateInfo *fi, ChunkCreateInfo *bi) const {
-    if (left != nullptr) {
-        left->populateInfo(li);
+// populate chunk create info from a snapshot of the blocks
+void Chunk::populateInfo(const ChunkSnapshot& blocks, ChunkCreateInfo *info) {
+//#define PRINT_MESH_TIME
+#ifdef PRINT_MESH_TIME
+    auto start = std::chrono::steady_clock::now();
+#endif
+    for (int section = 0; section < CHUNK_SECTIONS; section++) {
+        populateSection(blocks, info, section);
+    }
+    for (int edge = 0; edge < CHUNK_EDGES; edge++) {
+        populateEdge(blocks, info, FaceType(edge));
+    }
+#ifdef PRINT_MESH_TIME
+    std::chrono::duration<double, std::milli> time = std::chrono::steady_clock::now() - start;
+    std::cout << "Mesh time: " << time.count() << " ms" <<
+                 "\tgreedy: " << greedyMeshing << "\tbitmask: " << bitmaskCulling << std::endl;
+#endif
+}
+
+// populate the strip of faces on one side of the chunk, which is all
+// that changes when the neighbor on that side is created
+void Chunk::populateEdge(const ChunkSnapshot& blocks, ChunkCreateInfo *info, FaceType edge) {
+    SectionMesh& mesh = scratchMesh();
+    int s = (edge == RIGHT || edge == FRONT) ? 15 : 0;
+    if (greedyMeshing) {
+        createSliceGreedy(blocks, edge, s, 0, 256, mesh);
+    } else {
+        for (int i = 0; i < 16; i++) {
+            int x = (edge == LEFT || edge == RIGHT) ? s : i;
+            int z = (edge == LEFT || edge == RIGHT) ? i : s;
+            for (int y = 0; y < 256; y++) {
+                BlockType type = blocks.at(x, y, z);
+                if (type != EMPTY && !isCrossType(type)) {
+                    visitBlocks(blocks, x, y, z, mesh, 1 << edge);
+                }
+            }
+        }
+    }
+    info->edges[edge] = mesh;
+}
+
+// faces of a block that lie on the sides of the chunk
+int Chunk::edgeFaces(int x, int z) {
+    int faces = 0;
+    if (x == 0) {
+        faces |= 1 << LEFT;
+    } else if (x == 15) {
+        faces |= 1 << RIGHT;
+    }
+    if (z == 0) {
+        faces |= 1 << BACK;
+    } else if (z == 15) {
+        faces |= 1 << FRONT;
+    }
+    return faces;
+}
+
+// populate the mesh of a single section of the chunk create info
+void Chunk::populateSection(const ChunkSnapshot& blocks, ChunkCreateInfo *info, int section) {
+    if (blocks.sectionState(section) == SECTION_EMPTY) {
+        info->sections[section] = SectionMesh();
+        return;
+    }
+    SectionMesh& mesh = scratchMesh();
+    // the edge strips are too thin to gain from culling with bitmasks
+    static thread_local FaceCulling culling;
+    const FaceCulling* cull = nullptr;
+    if (bitmaskCulling) {
+        culling.build(blocks, section * 16, 16);
+        cull = &culling;
     }
-    if (right != nullptr) {
-        right->populateInfo(ri);
+    if (greedyMeshing) {
+        createCubesGreedy(blocks, section, mesh, cull);
+    } else {
+        createCubes(blocks, section, mesh, cull);
     }
-    if (front != nullptr) {
-        front->populateInfo(fi);
+    info->sections[section] = mesh;
+}
+
+// remesh one section and upload it, the other meshes stay on the gpu
+void Chunk::rebuildSection(int section) {
+    ChunkSnapshot blocks;
+    blocks.capture(*this);
+    ChunkCreateInfo info;
+    populateSection(blocks, &info, section);
+    uploadMeshes(&info, 1 << section, 0);
+}
+
+// upload the meshes of the given sections and edges, the others stay on the gpu,
+// meshes older than the ones already in place are dropped
+void Chunk::updateSections(ChunkCreateInfo *info, uint16_t sections, uint8_t edges,
+                           uint32_t stamp) {
+    m_meshJobs--;
+    uint16_t newerSections = 0;
+    uint8_t newerEdges = 0;
+    for (int section = 0; section < CHUNK_SECTIONS; section++) {
+        if ((sections & (1 << section)) && stamp > m_sectionStamps[section]) {
+            newerSections |= 1 << section;
+            m_sectionStamps[section] = stamp;
+        }
+    }
+    for (int edge = 0; edge < CHUNK_EDGES; edge++) {
+        if ((edges & (1 << edge)) && stamp > m_edgeStamps[edge]) {
+            newerEdges |= 1 << edge;
+            m_edgeStamps[edge] = stamp;
+        }
     }
-    if (back != nullptr) {
-        back->populateInfo(bi);
+    if (newerSections != 0 || newerEdges != 0) {
+        uploadMeshes(info, newerSections, newerEdges);
     }
 }
 
-// recreate this chunk and all neighbors
-void Chunk::updateSelf(const ChunkCreateInfo *info) {
-    destroy();
-    create(info);
+// stamp for a new mesh job, later jobs get larger stamps
+uint32_t Chunk::nextMeshStamp() {
+    m_meshJobs++;
+    return ++m_meshStamp;
 }
 
-// recreate all neighbors
-void Chunk::updateNeighbor(const ChunkCreateInfo *li, const ChunkCreateInfo *ri,
-                           const ChunkCreateInfo *fi, const ChunkCreateInfo *bi) {
-    if (left != nullptr) {
-        left->updateSelf(li);
+// whether a mesh job still holds this chunk, it must not be unloaded then
+bool Chunk::isMeshing() const {
+    return m_meshJobs > 0;
+}
+
+// mark a section for remeshing
+void Chunk::markSectionDirty(int section) {
+    if (section >= 0 && section < CHUNK_SECTIONS) {
+        m_dirtySections |= 1 << section;
     }
-    if (right != nullptr) {
-        right->updateSelf(ri);
+}
+
+// mark an edge strip for remeshing
+void Chunk::markEdgeDirty(FaceType edge) {
+    if (edge < CHUNK_EDGES) {
+        m_dirtyEdges |= 1 << edge;
     }
-    if (front != nullptr) {
-        front->updateSelf(fi);
+}
+
+// mark every section and edge strip for remeshing
+void Chunk::markAllDirty() {
+    m_dirtySections = 0xffff;
+    m_dirtyEdges = 0xf;
+    // the mesh is on its way, so edits from now on are remeshed as well
+    m_meshed = true;
+}
+
+bool Chunk::isDirty() const {
+    return m_dirtySections != 0 || m_dirtyEdges != 0;
+}
+
+bool Chunk::isMeshed() const {
+    return m_meshed;
+}
+
+// return the sections marked for remeshing and clear the marks
+uint16_t Chunk::takeDirtySections() {
+    uint16_t sections = m_dirtySections;
+    m_dirtySections = 0;
+    return sections;
+}
+
+// return the edge strips marked for remeshing and clear the marks
+uint8_t Chunk::takeDirtyEdges() {
+    uint8_t edges = m_dirtyEdges;
+    m_dirtyEdges = 0;
+    return edges;
+}
+
+// whether a section is empty, filled with a single type or mixed
+SectionState Chunk::sectionState(int section) const {
+    const BlockSection& blocks = m_sections[section];
+    if (!blocks.isUniform()) {
+        return SECTION_MIXED;
     }
-    if (back != nullptr) {
-        back->updateSelf(bi);
+    BlockType type = blocks.get(0);
+    if (type == EMPTY) {
+        return SECTION_EMPTY;
     }
+    // blocks of a single type hide the faces between each other,
+    // except for crossing decals which are always drawn
+    return isCrossType(type) ? SECTION_MIXED : SECTION_SOLID;
 }
 
 // get the blocktype located at that position in the chunk
 BlockType Chunk::blockAt(int x, int y, int z) const {
-    int index = x + y * 16 + z * 16 * 256;
-    return m_blocks[index];
+    return m_sections[y >> 4].get(getIndex(x, y, z));
 }
 
 // set the blocktype located at that position in the Chunk
-BlockType& Chunk::blockAt(int x, int y, int z) {
-    int index = x + y * 16 + z * 16 * 256;
-    return m_blocks[index];
+BlockRef Chunk::blockAt(int x, int y, int z) {
+    return BlockRef(*this, x, y, z);
 }
 
-// is empty or transparent
-bool Chunk::isOpaqueType(BlockType type) {
-    if (type == EMPTY || type == WATER || type == ICE || type == LAVA ||
-        isCrossType(type) || type == CLOUD) {
-        return false;
-    }
-    return true;
+// set the blocktype located at that position and update the heightmap
+void Chunk::setBlockAt(int x, int y, int z, BlockType type) {
+    m_sections[y >> 4].set(getIndex(x, y, z), type);
+    m_unsaved = true;
+    refreshHeight(x, z, y, y + 1, type);
 }
 
-bool Chunk::isCollidable(BlockType type) {
-    if (type == EMPTY || type == CLOUD || type == WATER || isCrossType(type)) {
-        return false;
+// fill the blocks y0 <= y < y1 of a column with a type, a section at a time
+void Chunk::fillColumn(int x, int z, int y0, int y1, BlockType type) {
+    y0 = std::max(y0, 0);
+    y1 = std::min(y1, 256);
+    if (y0 >= y1) {
+        return;
     }
-    return true;
+    for (int y = y0; y < y1;) {
+        int end = std::min(y1, (y & ~15) + 16);
+        m_sections[y >> 4].fill(getIndex(x, y, z), 16, end - y, type);
+        y = end;
+    }
+    m_unsaved = true;
+    refreshHeight(x, z, y0, y1, type);
 }
 
-bool Chunk::isCrossType(BlockType type) {
-    if (type == REDFLOWER || type == CROSSGRASS || type == MUSHROOM ||
-        type == GREYMUSHROOM || type == BUSH || type == DEADBRANCH) {
-        return true;
+// set the 256 blocks of a column from bottom to top, a run of one type at a time
+void Chunk::setColumn(int x, int z, const BlockType *types) {
+    int y0 = 0;
+    for (int y = 1; y <= 256; y++) {
+        // a run ends where the type changes or a section begins
+        if (y == 256 || types[y] != types[y0] || (y & 15) == 0) {
+            m_sections[y0 >> 4].fill(getIndex(x, y0, z), 16, y - y0, types[y0]);
+            y0 = y;
+        }
+    }
+    m_unsaved = true;
+    short& height = m_heights[x + z * 16];
+    height = -1;
+    for (int y = 255; y >= 0; y--) {
+        if (isCollidable(types[y])) {
+            height = y;
+            break;
+        }
     }
-    return false;
 }
 
-// set up vbo for all non-empty cubes in this chunk
-void Chunk::createCubes(std::vector<float>& opaque,
-                        std::vector<float>& transparency,
-                        std::vector<GLuint>& idx0,
-                        std::vector<GLuint>& idx1) const {
-    for (int i = 0; i < 16; i++) {
-        for (int j = 0; j < 256; j++) {
-            for (int k = 0; k < 16; k++) {
-                if (blockAt(i, j, k) != EMPTY){
-                    visitBlocks(i, j, k, opaque, transparency, idx0, idx1);
+// fill the blocks of a box with a type, min corner inclusive, max corner exclusive,
+// whole sections inside the box become uniform at once
+void Chunk::fillBox(int x0, int y0, int z0, int x1, int y1, int z1, BlockType type) {
+    x0 = std::max(x0, 0);
+    y0 = std::max(y0, 0);
+    z0 = std::max(z0, 0);
+    x1 = std::min(x1, 16);
+    y1 = std::min(y1, 256);
+    z1 = std::min(z1, 16);
+    if (x0 >= x1 || y0 >= y1 || z0 >= z1) {
+        return;
+    }
+    for (int y = y0; y < y1;) {
+        int end = std::min(y1, (y & ~15) + 16);
+        BlockSection& section = m_sections[y >> 4];
+        if (x1 - x0 == 16 && z1 - z0 == 16 && end - y == 16) {
+            section.fill(type);
+        } else {
+            for (int z = z0; z < z1; z++) {
+                for (int yi = y; yi < end; yi++) {
+                    section.fill(getIndex(x0, yi, z), 1, x1 - x0, type);
                 }
             }
         }
+        y = end;
+    }
+    m_unsaved = true;
+    for (int z = z0; z < z1; z++) {
+        for (int x = x0; x < x1; x++) {
+            refreshHeight(x, z, y0, y1, type);
+        }
     }
 }
 
-bool Chunk::isBlockOpaque(int i, int j, int k) const {
-    BlockType type = blockAt(i, j, k);
-    return isOpaqueType(type);
+// keep the height of a column up to date once its blocks y0 <= y < y1 became a type
+void Chunk::refreshHeight(int x, int z, int y0, int y1, BlockType type) {
+    short& height = m_heights[x + z * 16];
+    if (isCollidable(type)) {
+        if (y1 - 1 > height) {
+            height = y1 - 1;
+        }
+    } else if (height >= y0 && height < y1) {
+        // the top block was removed, look for the next one below
+        height = -1;
+        for (int j = y0 - 1; j >= 0; j--) {
+            if (isCollidable(m_sections[j >> 4].get(getIndex(x, j, z)))) {
+                height = j;
+                break;
+            }
+        }
+    }
 }
 
-// get the index located at a given position in this chunk
-int Chunk::getIndex(int x, int y, int z) const {
-    return x + y * 16 + z * 16 * 256;
+// get the y of the highest collidable block in a column, -1 when there is none
+int Chunk::heightAt(int x, int z) const {
+    return m_heights[x + z * 16];
 }
 
-// determine whether a face should be painted
-bool Chunk::shouldPaint(int x, int y, int z, FaceType face) const {
-    if (isBlockOpaque(x, y, z)) {
-        switch (face) {
-        case LEFT:
-            if ((x == 0 && (!left || !left->isBlockOpaque(15, y, z))) ||
-                    (x > 0 && x < 16 && !isBlockOpaque(x - 1, y, z))) {
-                return true;
-            } else {
-                return false;
-            }
-            break;
-        case RIGHT:
-            if ((x == 15 && (!right || !right->isBlockOpaque(0, y, z))) ||
-                    (x >= 0 && x < 15 && !isBlockOpaque(x + 1, y, z))) {
-                return true;
-            } else {
+const BiomeMap& Chunk::biomes() const {
+    return m_biomes;
+}
+
+size_t Chunk::blockBytes() const {
+    size_t bytes = 0;
+    for (const BlockSection& section : m_sections) {
+        bytes += section.byteSize();
+    }
+    return bytes;
+}
+
+// the first byte of saved chunk data, a full chunk holds its sections,
+// heights and edits, a delta chunk its edits alone
+// full (2): sections | 256 heights as little-endian shorts | edits
+// delta (3): edits
+// edits: count as a little-endian int | per edit its index as a short and type
+static const uint8_t CHUNK_FULL_V1 = 1;
+static const uint8_t CHUNK_FULL = 2;
+static const uint8_t CHUNK_DELTA = 3;
+
+// record a block the player placed or removed, after setting it
+void Chunk::recordEdit(int x, int y, int z, BlockType type) {
+    uint16_t index = uint16_t(x | (z << 4) | (y << 8));
+    auto it = std::lower_bound(m_edits.begin(), m_edits.end(), index,
+                               [](const BlockEdit &edit, uint16_t i) { return edit.index < i; });
+    if (it != m_edits.end() && it->index == index) {
+        it->type = type;
+    } else {
+        m_edits.insert(it, BlockEdit(index, type));
+    }
+}
+
+// a neighbor's assets reached into this chunk, so only a full copy can restore it
+void Chunk::markIrregenerable() {
+    m_regenerable = false;
+}
+
+// whether the chunk is best saved as its edits alone, a few bytes instead of
+// kilobytes of blocks, at the price of generating it again when loaded
+bool Chunk::prefersDelta() const {
+    return m_regenerable && (int)m_edits.size() <= deltaMaxEdits;
+}
+
+bool Chunk::awaitsReplay() const {
+    return m_replay;
+}
+
+// set the blocks of the edits again, once the regenerated chunk is decorated
+void Chunk::replayEdits() {
+    if (!m_replay) {
+        return;
+    }
+    for (const BlockEdit &edit : m_edits) {
+        setBlockAt(edit.index & 15, edit.index >> 8, (edit.index >> 4) & 15, edit.type);
+    }
+    m_replay = false;
+}
+
+// append the chunk to a byte buffer for saving, as its blocks and edits
+// or as its edits alone, as prefersDelta decides
+void Chunk::write(std::vector<uint8_t> &out) const {
+    bool delta = prefersDelta();
+    out.push_back(delta ? CHUNK_DELTA : CHUNK_FULL);
+    if (!delta) {
+        for (const BlockSection& section : m_sections) {
+            section.write(out);
+        }
+        for (short height : m_heights) {
+            out.push_back(uint8_t(height & 0xff));
+            out.push_back(uint8_t((height >> 8) & 0xff));
+        }
+    }
+    uint32_t count = (uint32_t)m_edits.size();
+    for (int i = 0; i < 32; i += 8) {
+        out.push_back(uint8_t(count >> i));
+    }
+    for (const BlockEdit &edit : m_edits) {
+        out.push_back(uint8_t(edit.index & 0xff));
+        out.push_back(uint8_t(edit.index >> 8));
+        out.push_back(uint8_t(edit.type));
+    }
+}
+
+// read what write appended, return false when the bytes are invalid,
+// a chunk read from its edits alone awaits generation and replay
+bool Chunk::read(const uint8_t *data, size_t size) {
+    const uint8_t *end = data + size;
+    if (size < 1) {
+        return false;
+    }
+    uint8_t format = *data++;
+    if (format != CHUNK_FULL_V1 && format != CHUNK_FULL && format != CHUNK_DELTA) {
+        return false;
+    }
+    if (format != CHUNK_DELTA) {
+        for (BlockSection& section : m_sections) {
+            if (!section.read(data, end)) {
                 return false;
             }
-            break;
-        case BOTTOM:
-            if (y == 0 || (y > 0 && y < 256 && !isBlockOpaque(x, y - 1, z))) {
-                return true;
-            } else {
+        }
+        if (end - data < 16 * 16 * 2) {
+            return false;
+        }
+        for (short& height : m_heights) {
+            height = short(data[0] | (data[1] << 8));
+            data += 2;
+        }
+    }
+    std::vector<BlockEdit> edits;
+    if (format != CHUNK_FULL_V1) {
+        if (end - data < 4) {
+            return false;
+        }
+        uint32_t count = data[0] | (data[1] << 8) | (data[2] << 16) | (uint32_t(data[3]) << 24);
+        data += 4;
+        if (size_t(end - data) != size_t(count) * 3) {
+            return false;
+        }
+        for (uint32_t i = 0; i < count; i++) {
+            uint16_t index = uint16_t(data[0] | (data[1] << 8));
+            if (data[2] > CLOUD || (!edits.empty() && index <= edits.back().index)) {
                 return false;
             }
-            break;
-        case TOP:
-            if (y == 255 || (y >= 0 && y < 255 && !isBlockOpaque(x, y + 1, z))) {
-                return true;
-            } else {
-                return false;
+            edits.push_back(BlockEdit(index, BlockType(data[2])));
+            data += 3;
+        }
+    }
+    if (data != end) {
+        return false;
+    }
+    m_edits.swap(edits);
+    // a full chunk may hold what its neighbors' assets put in it
+    m_regenerable = format == CHUNK_DELTA;
+    m_replay = format == CHUNK_DELTA;
+    m_unsaved = false;
+    return true;
+}
+
+bool Chunk::isUnsaved() const {
+    return m_unsaved;
+}
+
+void Chunk::markSaved() {
+    m_unsaved = false;
+}
+
+// is empty or transparent
+bool Chunk::isOpaqueType(BlockType type) {
+    return blockDefs[type].opaque;
+}
+
+bool Chunk::isCollidable(BlockType type) {
+    return blockDefs[type].collidable;
+}
+
+bool Chunk::isCrossType(BlockType type) {
+    return blockDefs[type].cross;
+}
+
+// set up vbo for all non-empty cubes in a section of this chunk
+void Chunk::createCubes(const ChunkSnapshot& blocks, int section, SectionMesh& mesh,
+                        const FaceCulling* culling) {
+    int y0 = section * 16;
+    // the inside of a solid section has no visible faces, visit its boundary only
+    bool solid = blocks.sectionState(section) == SECTION_SOLID;
+    for (int i = 0; i < 16; i++) {
+        for (int j = y0; j < y0 + 16; j++) {
+            bool boundary = i == 0 || i == 15 || j == y0 || j == y0 + 15;
+            for (int k = 0; k < 16; k++) {
+                if (solid && !boundary && k > 0 && k < 15) {
+                    continue;
+                }
+                if (blocks.at(i, j, k) != EMPTY){
+                    // faces on the sides of the chunk belong to the edge strips
+                    visitBlocks(blocks, i, j, k, mesh, ALL_FACES & ~edgeFaces(i, k), culling);
+                }
             }
-            break;
-        case BACK:
-            if ((z == 0 && (!back || !back->isBlockOpaque(x, y, 15))) ||
-                    (z > 0 && z < 16 && !isBlockOpaque(x, y, z - 1))) {
-                return true;
-            } else {
-                return false;
+        }
+    }
+}
+
+// set up vbo of a section by merging visible faces of the same type into larger quads
+void Chunk::createCubesGreedy(const ChunkSnapshot& blocks, int section, SectionMesh& mesh,
+                              const FaceCulling* culling) {
+    int y0 = section * 16;
+    bool solid = blocks.sectionState(section) == SECTION_SOLID;
+    // crossing decals are never merged
+    if (!solid) {
+        for (int i = 0; i < 16; i++) {
+            for (int j = y0; j < y0 + 16; j++) {
+                for (int k = 0; k < 16; k++) {
+                    if (isCrossType(blocks.at(i, j, k))) {
+                        visitBlocks(blocks, i, j, k, mesh);
+                    }
+                }
             }
-            break;
-        case FRONT:
-            if ((z == 15 && (!front || !front->isBlockOpaque(x, y, 0))) ||
-                    (z >= 0 && z < 15 && !isBlockOpaque(x, y, z + 1))) {
-                return true;
+        }
+    }
+    const FaceType faces[6] = {LEFT, RIGHT, FRONT, BACK, TOP, BOTTOM};
+    for (FaceType face : faces) {
+        int sBegin = 0;
+        int sEnd = 16;
+        // the outermost side slices belong to the edge strips
+        if (face == LEFT || face == BACK) {
+            sBegin = 1;
+        } else if (face == RIGHT || face == FRONT) {
+            sEnd = 15;
+        }
+        // a solid section can only show faces on its outermost slice
+        if (solid) {
+            if (face == TOP) {
+                sBegin = 15;
+            } else if (face == BOTTOM) {
+                sEnd = 1;
             } else {
-                return false;
+                continue;
             }
-            break;
-        default:
-            break;
         }
+        for (int s = sBegin; s < sEnd; s++) {
+            createSliceGreedy(blocks, face, s, y0, 16, mesh, culling);
+        }
+    }
+}
 
-    } else {
-        switch (face) {
-        case LEFT:
-            if ((x == 0 && (!left || left->blockAt(15, y, z) == EMPTY)) ||
-                    (x > 0 && x < 16 && blockAt(x - 1, y, z) == EMPTY)) {
-                return true;
-            } else {
-                return false;
+// merge the visible faces of one slice, from y0 up to y0 + height,
+// s is the position of the slice along the face normal
+void Chunk::createSliceGreedy(const ChunkSnapshot& blocks, FaceType face, int s, int y0, int height,
+                              SectionMesh& mesh, const FaceCulling* culling) {
+    // d is the axis along the face normal, u and v span the slice
+    int d = faceAxis[face];
+    int u = (d + 1) % 3;
+    int v = (d + 2) % 3;
+    const int dims[3] = {16, height, 16};
+    // at most the 16 x 256 faces of an edge strip
+    BlockType mask[16 * 256];
+    // collect the faces of this slice that should be painted
+    int pos[3];
+    pos[d] = s;
+    for (int j = 0; j < dims[v]; j++) {
+        for (int i = 0; i < dims[u]; i++) {
+            pos[u] = i;
+            pos[v] = j;
+            mask[i + j * dims[u]] = EMPTY;
+            // with bitmasks, hidden faces are skipped before reading the block
+            if (culling != nullptr && !culling->visible(face, pos[0], pos[1] + y0, pos[2])) {
+                continue;
             }
-            break;
-        case RIGHT:
-            if ((x == 15 && (!right || right->blockAt(0, y, z) == EMPTY)) ||
-                    (x >= 0 && x < 15 && blockAt(x + 1, y, z) == EMPTY)) {
-                return true;
-            } else {
-                return false;
+            BlockType type = blocks.at(pos[0], pos[1] + y0, pos[2]);
+            if (type != EMPTY && !isCrossType(type) &&
+                faceVisible(blocks, pos[0], pos[1] + y0, pos[2], face, culling)) {
+                mask[i + j * dims[u]] = type;
             }
-            break;
-        case BOTTOM:
-            if (y == 0 ||
-                    (y > 0 && y < 256 && blockAt(x, y - 1, z) == EMPTY)) {
-                return true;
-            } else {
-                return false;
+        }
+    }
+    // grow the widest, then tallest rectangle of the same type
+    for (int j = 0; j < dims[v]; j++) {
+        for (int i = 0; i < dims[u]; i++) {
+            BlockType type = mask[i + j * dims[u]];
+            if (type == EMPTY) {
+                continue;
             }
-            break;
-        case TOP:
-            if (y == 255 ||
-                    (y >= 0 && y < 255 && blockAt(x, y + 1, z) == EMPTY)) {
-                return true;
-            } else {
-                return false;
+            int w = 1;
+            while (i + w < dims[u] && mask[i + w + j * dims[u]] == type) {
+                w++;
             }
-            break;
-        case BACK:
-            if ((z == 0 && (!back || back->blockAt(x, y, 15) == EMPTY)) ||
-                    (z > 0 && z < 16 && blockAt(x, y, z - 1) == EMPTY)) {
-                return true;
-            } else {
-                return false;
+            int h = 1;
+            bool grow = true;
+            while (grow && j + h < dims[v]) {
+                for (int k = 0; k < w; k++) {
+                    if (mask[i + k + (j + h) * dims[u]] != type) {
+                        grow = false;
+                        break;
+                    }
+                }
+                if (grow) {
+                    h++;
+                }
             }
-            break;
-        case FRONT:
-            if ((z == 15 && (!front || front->blockAt(x, y, 0) == EMPTY)) ||
-                    (z >= 0 && z < 15 && blockAt(x, y, z + 1) == EMPTY)) {
-                return true;
-            } else {
-                return false;
+            for (int dj = 0; dj < h; dj++) {
+                for (int di = 0; di < w; di++) {
+                    mask[i + di + (j + dj) * dims[u]] = EMPTY;
+                }
             }
-            break;
-        default:
-            break;
+            int origin[3];
+            origin[d] = s;
+            origin[u] = i;
+            origin[v] = j;
+            origin[1] += y0;
+            addFace(mesh, type, face, origin[0], origin[1], origin[2], w, h);
         }
     }
-    return false;
+}
+
+// get the index located at a given position in its section
+int Chunk::getIndex(int x, int y, int z) const {
+    return x + (y & 15) * 16 + z * 16 * 16;
+}
+
+// determine whether a face should be painted, from the bitmasks when given
+bool Chunk::faceVisible(const ChunkSnapshot& blocks, int x, int y, int z, FaceType face,
+                        const FaceCulling* culling) {
+    if (culling != nullptr) {
+        return culling->visible(face, x, y, z);
+    }
+    return shouldPaint(blocks, x, y, z, face);
+}
+
+// determine whether a face should be painted, the snapshot border
+// stands in for the neighbors so no position needs a special case
+bool Chunk::shouldPaint(const ChunkSnapshot& blocks, int x, int y, int z, FaceType face) {
+    const int* n = faceSteps[face];
+    BlockType neighbor = blocks.at(x + n[0], y + n[1], z + n[2]);
+    if (isOpaqueType(blocks.at(x, y, z))) {
+        return !isOpaqueType(neighbor);
+    }
+    return neighbor == EMPTY;
 }
 
 // visit neighboring blocks and set up vbo for a single block
-void Chunk::visitBlocks(int x, int y, int z,
-                        std::vector<float>& opaque,
-                        std::vector<float>& transparency,
-                        std::vector<GLuint>& idx0,
-                        std::vector<GLuint>& idx1) const {
-    BlockType type = blockAt(x, y, z);
-    glm::vec4 currentPos = m_originPos + glm::vec4(x, y, z, 0);
+void Chunk::visitBlocks(const ChunkSnapshot& blocks, int x, int y, int z, SectionMesh& mesh, int faces,
+                        const FaceCulling* culling) {
+    BlockType type = blocks.at(x, y, z);
     // if is a crossing decal
     if (isCrossType(type)) {
-        std::vector<glm::vec4> pos;
-        pos.push_back(currentPos + glm::vec4(0, 0, 0.5, 0));
-        pos.push_back(currentPos + glm::vec4(1, 0, 0.5, 0));
-        pos.push_back(currentPos + glm::vec4(1, 1, 0.5, 0));
-        pos.push_back(currentPos + glm::vec4(0, 1, 0.5, 0));
-        addFace(pos, type, opaque, transparency, idx0, idx1, FRONT);
-        pos.clear();
-        pos.push_back(currentPos + glm::vec4(0.5, 0, 1, 0));
-        pos.push_back(currentPos + glm::vec4(0.5, 0, 0, 0));
-        pos.push_back(currentPos + glm::vec4(0.5, 1, 0, 0));
-        pos.push_back(currentPos + glm::vec4(0.5, 1, 1, 0));
-        addFace(pos, type, opaque, transparency, idx0, idx1, RIGHT);
-        pos.clear();
-        pos.push_back(currentPos + glm::vec4(1, 0, 0.5, 0));
-        pos.push_back(currentPos + glm::vec4(0, 0, 0.5, 0));
-        pos.push_back(currentPos + glm::vec4(0, 1, 0.5, 0));
-        pos.push_back(currentPos + glm::vec4(1, 1, 0.5, 0));
-        addFace(pos, type, opaque, transparency, idx0, idx1, BACK);
-        pos.clear();
-        pos.push_back(currentPos + glm::vec4(0.5, 0, 0, 0));
-        pos.push_back(currentPos + glm::vec4(0.5, 0, 1, 0));
-        pos.push_back(currentPos + glm::vec4(0.5, 1, 1, 0));
-        pos.push_back(currentPos + glm::vec4(0.5, 1, 0, 0));
-        addFace(pos, type, opaque, transparency, idx0, idx1, LEFT);
+        for (FaceType face : crossFaces) {
+            addFace(mesh, type, face, x, y, z);
+        }
         return;
     }
     // if the adjancant block is empty, we need to render
-    if (shouldPaint(x, y, z, LEFT)){
-        std::vector<glm::vec4> pos;
-        pos.push_back(currentPos + glm::vec4(0, 0, 0, 0));
-        pos.push_back(currentPos + glm::vec4(0, 0, 1, 0));
-        pos.push_back(currentPos + glm::vec4(0, 1, 1, 0));
-        pos.push_back(currentPos + glm::vec4(0, 1, 0, 0));
-        addFace(pos, type, opaque, transparency, idx0, idx1, LEFT);
-    }
-    if (shouldPaint(x, y, z, RIGHT)) {
-        std::vector<glm::vec4> pos;
-        pos.push_back(currentPos + glm::vec4(1, 0, 1, 0));
-        pos.push_back(currentPos + glm::vec4(1, 0, 0, 0));
-        pos.push_back(currentPos + glm::vec4(1, 1, 0, 0));
-        pos.push_back(currentPos + glm::vec4(1, 1, 1, 0));
-        addFace(pos, type, opaque, transparency, idx0, idx1, RIGHT);
-    }
-    if (shouldPaint(x, y, z, BOTTOM)) {
-        std::vector<glm::vec4> pos;
-        pos.push_back(currentPos + glm::vec4(0, 0, 0, 0));
-        pos.push_back(currentPos + glm::vec4(1, 0, 0, 0));
-        pos.push_back(currentPos + glm::vec4(1, 0, 1, 0));
-        pos.push_back(currentPos + glm::vec4(0, 0, 1, 0));
-        addFace(pos, type, opaque, transparency, idx0, idx1, BOTTOM);
-    }
-    if (shouldPaint(x, y, z, TOP)) {
-        std::vector<glm::vec4> pos;
-        pos.push_back(currentPos + glm::vec4(0, 1, 1, 0));
-        pos.push_back(currentPos + glm::vec4(1, 1, 1, 0));
-        pos.push_back(currentPos + glm::vec4(1, 1, 0, 0));
-        pos.push_back(currentPos + glm::vec4(0, 1, 0, 0));
-        addFace(pos, type, opaque, transparency, idx0, idx1, TOP);
-    }
-    if (shouldPaint(x, y, z, BACK)) {
-        std::vector<glm::vec4> pos;
-        pos.push_back(currentPos + glm::vec4(1, 0, 0, 0));
-        pos.push_back(currentPos + glm::vec4(0, 0, 0, 0));
-        pos.push_back(currentPos + glm::vec4(0, 1, 0, 0));
-        pos.push_back(currentPos + glm::vec4(1, 1, 0, 0));
-        addFace(pos, type, opaque, transparency, idx0, idx1, BACK);
-    }
-    if (shouldPaint(x, y, z, FRONT)) {
-        std::vector<glm::vec4> pos;
-        pos.push_back(currentPos + glm::vec4(0, 0, 1, 0));
-        pos.push_back(currentPos + glm::vec4(1, 0, 1, 0));
-        pos.push_back(currentPos + glm::vec4(1, 1, 1, 0));
-        pos.push_back(currentPos + glm::vec4(0, 1, 1, 0));
-        addFace(pos, type, opaque, transparency, idx0, idx1, FRONT);
-    }
-}
-
-// add face for a block
-void Chunk::addFace(std::vector<glm::vec4> pos, BlockType type,
-                    std::vector<float>& opaque,
-                    std::vector<float>& transparency,
-                    std::vector<GLuint>& idx0,
-                    std::vector<GLuint>& idx1,
-                    FaceType face) const {
-    glm::vec3 normal = glm::normalize(glm::cross(glm::vec3(pos[0])- glm::vec3(pos[1]),
-                                      glm::vec3(pos[0])- glm::vec3(pos[2])));
-    int size0 = opaque.size() / 16;
-    int size1 = transparency.size() / 16;
-    // vert -> pos1nor1col1uv1
-    for (int i = 0; i < 4; i++){
-        if (isOpaqueType(type)) {
-            for (int j = 0; j < 4; j++) {
-               opaque.push_back(pos[i][j]);
-            }
-            for (int j = 0; j < 3; j++) {
-               opaque.push_back(normal[j]);
-            }
-            for (int j = 0; j < 5; j++) {
-               opaque.push_back(0);
-            }
-            addUV(opaque, type, face, i);
-            idx0.push_back(size0);
-            idx0.push_back(size0 + 1);
-            idx0.push_back(size0 + 2);
-            idx0.push_back(size0);
-            idx0.push_back(size0 + 2);
-            idx0.push_back(size0 + 3);
-        }
-        else {
-            for (int j = 0; j < 4; j++) {
-               transparency.push_back(pos[i][j]);
-            }
-            for (int j = 0; j < 3; j++) {
-               transparency.push_back(normal[j]);
-            }
-            for (int j = 0; j < 5; j++) {
-               transparency.push_back(0);
-            }
-            addUV(transparency, type, face, i);
-            idx1.push_back(size1);
-            idx1.push_back(size1 + 1);
-            idx1.push_back(size1 + 2);
-            idx1.push_back(size1);
-            idx1.push_back(size1 + 2);
-            idx1.push_back(size1 + 3);
+    for (FaceType face : blockFaces) {
+        if ((faces & (1 << face)) && faceVisible(blocks, x, y, z, face, culling)) {
+            addFace(mesh, type, face, x, y, z);
         }
     }
 }
 
-// add uv for a block
-void Chunk::addUV(std::vector<float>& verts, BlockType type, FaceType face,
-                  int i) const {
-    float x = 0;
-    float y = 0;
-    float cosine = 0;
-    int animated = 0;
-    switch (type) {
-    case GRASS:
-        cosine = 5;
-        if (face == TOP) {
-            x = 8.01;
-            y = 13.01;
-        }
-        else {
-            x = 3.01;
-            y = 15.01;
-        }
-        break;
-    case DIRT:
-        cosine = 5;
-        x = 2.01;
-        y = 15.01;
-        break;
-    case STONE:
-        cosine = 3;
-        x = 1.01;
-        y = 15.01;
-        break;
-    case LAVA:
-        animated = 1;
-        cosine = 8;
-        x = 14.01;
-        y = 1.01;
-        break;
-    case WATER:
-        animated = 1;
-        cosine = 8;
-        x = 14.01;
-        y = 3.01;
-        break;
-    case SNOW:
-        cosine = 5;
-        if (face == TOP) {
-            x = 2.01;
-            y = 11.01;
-        }
-        else {
-            x = 4.01;
-            y = 11.01;
-        }
-        break;
-    case BEDROCK:
-        cosine = 3;
-        x = 1.01;
-        y = 14.01;
-        break;
-    case WOOD:
-        cosine = 5;
-        if (face == TOP) {
-            x = 5.01;
-            y = 14.01;
-        }
-        else {
-            x = 4.01;
-            y = 14.01;
-        }
-        break;
-    case LEAF:
-        cosine = 5;
-        animated = 10;
-        x = 5.01;
-        y = 12.01;
-        break;
-    case ICE:
-        cosine = 3;
-        x = 3.01;
-        y = 11.01;
-        break;
-    case REDFLOWER:
-        cosine = 5;
-        x = 12.01;
-        y = 15.01;
-        break;
-    case CROSSGRASS:
-        cosine = 5;
-        x = 7.01;
-        y = 13.01;
-        break;
-    case MUSHROOM:
-        cosine = 5;
-        x = 12.01;
-        y = 14.01;
-        break;
-    case LAKEBOTTOM:
-        cosine = 3;
-        x = 2.01;
-        y = 14.01;
-        break;
-    case SAND:
-        cosine = 5;
-        x = 0.01;
-        y = 4.01;
-        break;
-    case EVIL:
-        cosine = 5;
-        x = 5.01;
-        y = 13.01;
-        break;
-    case LEAFMOLD:
-        cosine = 5;
-        x = 4.01;
-        y = 12.01;
-        break;
-    case FROZEDIRT:
-        cosine = 5;
-        if (face == TOP) {
-            x = 14.01;
-            y = 11.01;
-        } else {
-            x = 13.01;
-            y = 11.01;
-        }
-        break;
-    case GREYMUSHROOM:
-        cosine = 5;
-        x = 13.01;
-        y = 14.01;
-        break;
-    case BUSH:
-        cosine = 5;
-        x = 15.01;
-        y = 12.01;
-        break;
-    case DEADBRANCH:
-        cosine = 5;
-        x = 7.01;
-        y = 12.01;
-        break;
-    case GOLD:
-        cosine = 3;
-        x = 0.01;
-        y = 13.01;
-        break;
-    case COAL:
-        cosine = 3;
-        x = 2.01;
-        y = 13.01;
-        break;
-    case RUBY:
-        cosine = 3;
-        x = 3.01;
-        y = 12.01;
-        break;
-    case YELLOWROCK:
-        cosine = 5;
-        x = 2.01;
-        y = 5.01;
-        break;
-    case ORANGEROCK:
-        cosine = 5;
-        x = 2.01;
-        y = 2.01;
-        break;
-    case REDROCK:
-        cosine = 5;
-        x = 1.01;
-        y = 7.01;
-        break;
-    case CLOUD:
-        cosine = 8;
-        x = -1;
-        y = -1;
-        animated = 9;
-        break;
-    default:
-        break;
-    }
-    if ((type == LAVA || type == WATER) &&
-        (face != TOP && face != BOTTOM)) {
-        switch (i) {
-        case 0:
-            y += 0.98; break;
-        case 1:
-            break;
-        case 2:
-            x += 0.98; break;
-        case 3:
-            x += 0.98; y += 0.98; break;
-        default: break;
-        }
-    } else {
-        if (i == 1 || i == 2) {
-            x += 0.98;
-        }
-        if (i == 2 || i == 3) {
-            y += 0.98;
-        }
+// add face for a block, from the corner at (x, y, z) and
+// spanning w x h blocks along the two axes of the face
+void Chunk::addFace(SectionMesh& mesh, BlockType type, FaceType face,
+                    int x, int y, int z, int w, int h) {
+    bool opaque = blockDefs[type].opaque;
+    std::vector<GLuint>& verts = opaque ? mesh.opaque : mesh.transparency;
+    int& quads = opaque ? mesh.quads0 : mesh.quads1;
+    int extent[3] = {1, 1, 1};
+    extent[(faceAxis[face] + 1) % 3] = w;
+    extent[(faceAxis[face] + 2) % 3] = h;
+    GLuint material = materials.words[type][face];
+    // vert -> pos1face1, uv1material1
+    for (int i = 0; i < 4; i++) {
+        const int* corner = faceCorners[face][i];
+        GLuint vx = x + corner[0] * extent[0];
+        GLuint vy = y + corner[1] * extent[1];
+        GLuint vz = z + corner[2] * extent[2];
+        verts.push_back(vx | (vy << 5) | (vz << 14) | ((GLuint)face << 19));
+        verts.push_back(material);
     }
-    verts.push_back(x / 16.0);
-    verts.push_back(y / 16.0);
-    verts.push_back(cosine);
-    verts.push_back(animated);
+    quads++;
 }
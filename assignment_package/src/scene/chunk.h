@@ -3,6 +3,9 @@
 #include "drawable.h"
 #include "la.h"
 #include "smartpointerhelp.h"
+#include "blocksection.h"
+#include "biomemap.h"
+#include <algorithm>
 
 enum BlockType : unsigned char
 {
@@ -17,24 +20,125 @@ enum FaceType : unsigned char
     LEFT, RIGHT, FRONT, BACK, TOP, BOTTOM
 };
 
+// chunk vertices are packed into two GLuints, positions are chunk-local
+// word 0: x (5 bits) | y (9 bits) | z (5 bits) | face (3 bits)
+// word 1: tile x (4 bits) | tile y (4 bits) | cosine (4 bits) |
+//         animated (4 bits) | cross decal (1 bit) | untextured (1 bit)
+const int CHUNK_VERTEX_WORDS = 2;
+
+// a chunk is a stack of 16 sections of 16 x 16 x 16 blocks
+const int CHUNK_SECTIONS = 16;
+// the faces on each side of a chunk form a strip, indexed by LEFT, RIGHT, FRONT, BACK
+const int CHUNK_EDGES = 4;
+// the meshes of a chunk, its sections then its edge strips
+const int CHUNK_MESHES = CHUNK_SECTIONS + CHUNK_EDGES;
+const int ALL_FACES = 63;
+
+enum SectionState : unsigned char
+{
+    // only air, has no faces
+    SECTION_EMPTY,
+    // a single block type, only the boundary of the section can have faces
+    SECTION_SOLID,
+    SECTION_MIXED
+};
+
+// a block the player placed or removed, index = x | z << 4 | y << 8 in the chunk
+class BlockEdit
+{
+public:
+    uint16_t index;
+    BlockType type;
+public:
+    BlockEdit(uint16_t i, BlockType t): index(i), type(t) {}
+};
+
+// the mesh of a single section
+class SectionMesh
+{
+public:
+    // number of quads in each vbo, drawn with the shared quad indices
+    int quads0 = 0;
+    int quads1 = 0;
+    std::vector<GLuint> opaque;
+    std::vector<GLuint> transparency;
+    // empty the mesh but keep its buffers
+    void clear();
+};
+
 class ChunkCreateInfo
 {
 public:
-    std::vector<GLuint> idx0;
-    std::vector<GLuint> idx1;
-    std::vector<float> opaque;
-    std::vector<float> transparency;
+    // meshed per section, so a rebuild can target a single one
+    SectionMesh sections[CHUNK_SECTIONS];
+    // faces on the sides of the chunk, the only ones that depend on its neighbors
+    SectionMesh edges[CHUNK_EDGES];
+    // number of quads in each vbo over all sections and edges
+    int quads0() const;
+    int quads1() const;
 };
 
+class Chunk;
+
+// stands in for BlockType& now that blocks are bit-packed,
+// writes go through Chunk::setBlockAt to keep the heightmap up to date
+class BlockRef
+{
+private:
+    Chunk& m_chunk;
+    int m_x, m_y, m_z;
+
+public:
+    BlockRef(Chunk& chunk, int x, int y, int z) :
+        m_chunk(chunk), m_x(x), m_y(y), m_z(z) {}
+    operator BlockType() const;
+    BlockRef& operator=(BlockType type);
+    BlockRef& operator=(const BlockRef& other);
+};
+
+class FaceCulling;
+class ChunkSnapshot;
+
 class Chunk : public Drawable
 {
     friend class Terrain;
+    friend class ChunkSnapshot;
+    friend class BlockCursor;
 
 private:
-    // A 1D list of blocks
-    std::vector<BlockType> m_blocks;
+    // 16 palette-compressed sections stacked along y
+    BlockSection m_sections[CHUNK_SECTIONS];
+    // the words of the opaque and the transparent vertices of every mesh, laid out one
+    // after another in the vbos, the vertices themselves are only kept on the gpu
+    uint32_t m_opaqueWords[CHUNK_MESHES];
+    uint32_t m_transparentWords[CHUNK_MESHES];
+    // y of the highest collidable block of every column, -1 when there is none
+    short m_heights[16 * 16];
+    // the biome of every column, set when the chunk is generated or loaded
+    BiomeMap m_biomes;
     // word position of the origin
     glm::vec4 m_originPos;
+    // bit i is set when section i was edited and needs remeshing
+    uint16_t m_dirtySections;
+    // bit i is set when edge strip i needs remeshing
+    uint8_t m_dirtyEdges;
+    // whether a mesh has been uploaded or queued, later edits are remeshed
+    bool m_meshed;
+    // stamp of the newest mesh job, and of the section and edge meshes uploaded
+    uint32_t m_meshStamp;
+    uint32_t m_sectionStamps[CHUNK_SECTIONS];
+    uint32_t m_edgeStamps[CHUNK_EDGES];
+    // mesh jobs that hold a pointer to this chunk and have not been applied yet
+    uint16_t m_meshJobs;
+    // whether the blocks changed since they were last saved or loaded
+    bool m_unsaved;
+    // the player's edits sorted by index, the last edit of each block
+    std::vector<BlockEdit> m_edits;
+    // whether generating and decorating the chunk again and replaying the edits
+    // gives back its blocks, false once a neighbor's assets or a river reach into it
+    bool m_regenerable;
+    // loaded from its edits alone, the edits are replayed once it is decorated
+    bool m_replay;
     // the neighbors of the chunks
     Chunk* left;
     Chunk* right;
@@ -44,67 +148,168 @@ private:
 public:
     Chunk(OpenGLContext* context) :
         Drawable(context),
-        m_blocks(std::vector<BlockType>(16 * 256 * 16)),
-        left(nullptr), right(nullptr), front(nullptr), back(nullptr) {}
+        m_dirtySections(0), m_dirtyEdges(0), m_meshed(false), m_meshStamp(0), m_meshJobs(0),
+        m_unsaved(true), m_edits(), m_regenerable(true), m_replay(false),
+        left(nullptr), right(nullptr), front(nullptr), back(nullptr) {
+        std::fill(m_heights, m_heights + 16 * 16, -1);
+        std::fill(m_opaqueWords, m_opaqueWords + CHUNK_MESHES, 0);
+        std::fill(m_transparentWords, m_transparentWords + CHUNK_MESHES, 0);
+        std::fill(m_sectionStamps, m_sectionStamps + CHUNK_SECTIONS, 0);
+        std::fill(m_edgeStamps, m_edgeStamps + CHUNK_EDGES, 0);
+    }
     Chunk(OpenGLContext* context, glm::vec4 pos) :
         Drawable(context),
-        m_blocks(std::vector<BlockType>(16 * 256 * 16)),
         m_originPos(pos),
-        left(nullptr), right(nullptr), front(nullptr), back(nullptr) {}
+        m_dirtySections(0), m_dirtyEdges(0), m_meshed(false), m_meshStamp(0), m_meshJobs(0),
+        m_unsaved(true), m_edits(), m_regenerable(true), m_replay(false),
+        left(nullptr), right(nullptr), front(nullptr), back(nullptr) {
+        std::fill(m_heights, m_heights + 16 * 16, -1);
+        std::fill(m_opaqueWords, m_opaqueWords + CHUNK_MESHES, 0);
+        std::fill(m_transparentWords, m_transparentWords + CHUNK_MESHES, 0);
+        std::fill(m_sectionStamps, m_sectionStamps + CHUNK_SECTIONS, 0);
+        std::fill(m_edgeStamps, m_edgeStamps + CHUNK_EDGES, 0);
+    }
+    Chunk(const Chunk& other) = default;
+    // generated chunks are moved into the terrain
+    Chunk(Chunk&& other) = default;
     virtual ~Chunk() {}
     // openGL create
     void create() override;
+    // chunk vbos hold packed vertices relative to the chunk origin
+    bool isPacked() override;
+    glm::vec4 packedOrigin() override;
     void create(const ChunkCreateInfo *info);
-    // populate and create this and all neighbors
-    void combinedCreate();
-    // populate chunk create info
+    // populate chunk create info from the blocks of this chunk and its current neighbors
     void populateInfo(ChunkCreateInfo *info) const;
-    // populate chunk create info of neighbors
-    void populateNeighbor(ChunkCreateInfo *li, ChunkCreateInfo *ri,
-                          ChunkCreateInfo *fi, ChunkCreateInfo *bi) const;
-    // recreate this chunk
-    void updateSelf(const ChunkCreateInfo *info);
-    // recreate all neighbors
-    void updateNeighbor(const ChunkCreateInfo *li, const ChunkCreateInfo *ri,
-                        const ChunkCreateInfo *fi, const ChunkCreateInfo *bi);
+    // the meshers below read only from a snapshot of the blocks,
+    // so they can run on any thread while the chunk is edited
+    // populate chunk create info
+    static void populateInfo(const ChunkSnapshot& blocks, ChunkCreateInfo *info);
+    // populate the mesh of a single section of chunk create info
+    static void populateSection(const ChunkSnapshot& blocks, ChunkCreateInfo *info, int section);
+    // populate the strip of faces on one side of chunk create info
+    static void populateEdge(const ChunkSnapshot& blocks, ChunkCreateInfo *info, FaceType edge);
+    // remesh a single section and upload it
+    void rebuildSection(int section);
+    // upload the meshes of the given sections and edges,
+    // unless newer meshes from a job with a larger stamp are already in place
+    void updateSections(ChunkCreateInfo *info, uint16_t sections, uint8_t edges,
+                        uint32_t stamp);
+    // stamp for a new mesh job, later jobs get larger stamps,
+    // every stamp handed out is given back by updateSections
+    uint32_t nextMeshStamp();
+    // whether a mesh job still holds this chunk, it must not be unloaded then
+    bool isMeshing() const;
+    // mark a section or an edge strip for remeshing
+    void markSectionDirty(int section);
+    void markEdgeDirty(FaceType edge);
+    // mark everything for remeshing, which queues the first mesh of a new chunk
+    void markAllDirty();
+    bool isDirty() const;
+    // whether a mesh has been uploaded or queued
+    bool isMeshed() const;
+    // return the sections and edges marked for remeshing and clear the marks
+    uint16_t takeDirtySections();
+    uint8_t takeDirtyEdges();
+    // whether a section is empty, filled with a single type or mixed
+    SectionState sectionState(int section) const;
     // get the blocktype located at that position in this chunk
     BlockType blockAt(int x, int y, int z) const;
     // set the blocktype located at that position in this Chunk
-    BlockType& blockAt(int x, int y, int z);
+    BlockRef blockAt(int x, int y, int z);
+    void setBlockAt(int x, int y, int z, BlockType type);
+    // fill the blocks y0 <= y < y1 of a column with a type
+    void fillColumn(int x, int z, int y0, int y1, BlockType type);
+    // set the 256 blocks of a column from bottom to top
+    void setColumn(int x, int z, const BlockType *types);
+    // fill the blocks of a box with a type, min corner inclusive, max corner exclusive
+    void fillBox(int x0, int y0, int z0, int x1, int y1, int z1, BlockType type);
+    // get the y of the highest collidable block in a column, -1 when there is none
+    int heightAt(int x, int z) const;
+    // the biome of every column
+    const BiomeMap& biomes() const;
+    // bytes used by the blocks of this chunk
+    size_t blockBytes() const;
+    // record a block the player placed or removed, after setting it
+    void recordEdit(int x, int y, int z, BlockType type);
+    // a neighbor's assets or a river reached into this chunk, so only a full copy can restore it
+    void markIrregenerable();
+    // whether the chunk is best saved as its edits alone, see deltaMaxEdits
+    bool prefersDelta() const;
+    // whether the chunk was loaded from its edits alone and they wait to be replayed
+    bool awaitsReplay() const;
+    // set the blocks of the edits again, once the regenerated chunk is decorated
+    void replayEdits();
+    // append the chunk to a byte buffer for saving, as its blocks and edits
+    // or as its edits alone, as prefersDelta decides
+    void write(std::vector<uint8_t> &out) const;
+    // read what write appended, return false when the bytes are invalid,
+    // a chunk read from its edits alone awaits generation and replay
+    bool read(const uint8_t *data, size_t size);
+    // whether the blocks changed since they were last saved or loaded
+    bool isUnsaved() const;
+    void markSaved();
+public:
+    // merge coplanar faces of the same block type into larger quads
+    // when meshing, otherwise emit one quad per exposed face
+    static bool greedyMeshing;
+    // find visible faces with row bitmasks instead of testing every face
+    static bool bitmaskCulling;
+    // save chunks that can be regenerated as their edits alone
+    // while they have at most this many, 0 always saves every block
+    static int deltaMaxEdits;
 public:
     static bool isOpaqueType(BlockType type);
     static bool isCollidable(BlockType type);
     static bool isCrossType(BlockType type);
 private:
-    // set up vbo for all non-empty cubes in this chunk
-    void createCubes(std::vector<float>& opaque,
-                     std::vector<float>& transparency,
-                     std::vector<GLuint>& idx0,
-                     std::vector<GLuint>& idx1) const;
-    // is empty or transparent
-    bool isBlockOpaque(int i, int j, int k) const;
-    // return the index located at that position in this chunk
+    // upload the meshes of the given sections and edges of a create info,
+    // the others stay as they are on the gpu
+    void uploadMeshes(const ChunkCreateInfo *info, uint16_t sections, uint8_t edges);
+    // a new vbo of every mesh of one pass, uploading the replaced ones, those that are
+    // not null, and copying the others on the gpu from the old vbo, updates words
+    GLuint spliceBuffer(GLuint old, bool hasOld, uint32_t *words,
+                        const std::vector<GLuint> *const *replaced);
+    // set up vbo for all non-empty cubes in a section
+    static void createCubes(const ChunkSnapshot& blocks, int section, SectionMesh& mesh,
+                            const FaceCulling* culling = nullptr);
+    // set up vbo of a section by merging visible faces of the same type into larger quads
+    static void createCubesGreedy(const ChunkSnapshot& blocks, int section, SectionMesh& mesh,
+                                  const FaceCulling* culling = nullptr);
+    // merge the visible faces of one slice, from y0 up to y0 + height
+    static void createSliceGreedy(const ChunkSnapshot& blocks, FaceType face, int s, int y0, int height,
+                                  SectionMesh& mesh, const FaceCulling* culling = nullptr);
+    // faces of a block that lie on the sides of the chunk, as a bitmask
+    static int edgeFaces(int x, int z);
+    // return the index located at that position in its section
     int getIndex(int x, int y, int z) const;
+    // keep the height of a column up to date once its blocks y0 <= y < y1 became a type
+    void refreshHeight(int x, int z, int y0, int y1, BlockType type);
     // determine whether a face should be painted
-    bool shouldPaint(int i, int j, int k, FaceType face) const;
+    static bool shouldPaint(const ChunkSnapshot& blocks, int x, int y, int z, FaceType face);
+    // determine whether a face should be painted, from the bitmasks when given
+    static bool faceVisible(const ChunkSnapshot& blocks, int x, int y, int z, FaceType face,
+                            const FaceCulling* culling);
     // visit neighboring blocks and set up vbo for a single block
-    void visitBlocks(int x, int y, int z,
-                     std::vector<float>& verts,
-                     std::vector<float>& transparency,
-                     std::vector<GLuint>& idx0,
-                     std::vector<GLuint>& idx1) const;
-    // add face for a block
-    void addFace(std::vector<glm::vec4> vertices, BlockType type,
-                 std::vector<float>& verts,
-                 std::vector<float>& transparency,
-                 std::vector<GLuint>& idx0,
-                 std::vector<GLuint>& idx1,
-                 FaceType face) const;
-    // add uv for a block
-    void addUV(std::vector<float>& verts,
-               BlockType type,
-               FaceType face,
-               int i) const;
+    static void visitBlocks(const ChunkSnapshot& blocks, int x, int y, int z, SectionMesh& mesh,
+                            int faces = ALL_FACES, const FaceCulling* culling = nullptr);
+    // add face for a block, from a chunk-local corner and
+    // spanning w x h blocks along the two axes of the face
+    static void addFace(SectionMesh& mesh, BlockType type, FaceType face,
+                        int x, int y, int z, int w = 1, int h = 1);
 };
 
+inline BlockRef::operator BlockType() const {
+    return static_cast<const Chunk&>(m_chunk).blockAt(m_x, m_y, m_z);
+}
+
+inline BlockRef& BlockRef::operator=(BlockType type) {
+    m_chunk.setBlockAt(m_x, m_y, m_z, type);
+    return *this;
+}
+
+inline BlockRef& BlockRef::operator=(const BlockRef& other) {
+    return *this = BlockType(other);
+}
+
 #endif // CHUNK_H
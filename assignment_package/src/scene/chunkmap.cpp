@@ -0,0 +1,72 @@
+#include "chunkmap.h"
+#include "chunk.h"
+
+static const size_t INITIAL_SLOTS = 64;
+
+ChunkMap::ChunkMap() :
+    m_slots(INITIAL_SLOTS), m_mask(INITIAL_SLOTS - 1), m_size(0)
+{}
+
+ChunkMap::~ChunkMap() {}
+
+// add a chunk under a key and return it, or return the chunk already there
+Chunk* ChunkMap::insert(int64_t key, uPtr<Chunk> chunk) {
+    Chunk* existing = find(key);
+    if (existing != nullptr) {
+        return existing;
+    }
+    if ((m_size + 1) * 2 > m_slots.size()) {
+        grow();
+    }
+    size_t i = home(key);
+    while (m_slots[i].chunk != nullptr) {
+        i = (i + 1) & m_mask;
+    }
+    m_slots[i].key = key;
+    m_slots[i].chunk = std::move(chunk);
+    m_size++;
+    return m_slots[i].chunk.get();
+}
+
+// remove and free the chunk of a key, the slots after it that probed past it
+// are shifted back, so lookups never need tombstones
+void ChunkMap::erase(int64_t key) {
+    size_t i = home(key);
+    while (true) {
+        if (m_slots[i].chunk == nullptr) {
+            return;
+        }
+        if (m_slots[i].key == key) {
+            break;
+        }
+        i = (i + 1) & m_mask;
+    }
+    m_slots[i].chunk = nullptr;
+    m_size--;
+    for (size_t j = (i + 1) & m_mask; m_slots[j].chunk != nullptr; j = (j + 1) & m_mask) {
+        // move the chunk at j into the hole at i unless its home lies cyclically in (i, j]
+        size_t h = home(m_slots[j].key);
+        if ((j > i && (h <= i || h > j)) || (j < i && (h <= i && h > j))) {
+            m_slots[i].key = m_slots[j].key;
+            m_slots[i].chunk = std::move(m_slots[j].chunk);
+            i = j;
+        }
+    }
+}
+
+// double the slots and put every chunk in its new place, the chunks do not move
+void ChunkMap::grow() {
+    std::vector<Slot> old(m_slots.size() * 2);
+    old.swap(m_slots);
+    m_mask = m_slots.size() - 1;
+    for (Slot& slot : old) {
+        if (slot.chunk != nullptr) {
+            size_t i = home(slot.key);
+            while (m_slots[i].chunk != nullptr) {
+                i = (i + 1) & m_mask;
+            }
+            m_slots[i].key = slot.key;
+            m_slots[i].chunk = std::move(slot.chunk);
+        }
+    }
+}
@@ -0,0 +1,87 @@
+#ifndef CHUNKMAP_H
+#define CHUNKMAP_H
+
+#include <cstdint>
+#include <vector>
+#include "smartpointerhelp.h"
+
+class Chunk;
+
+// the loaded chunks by key, a flat open-addressing hash table with linear probing,
+// a lookup is a multiply and a short scan of adjacent slots instead of a walk down
+// a tree, every chunk lives in its own allocation, so a Chunk* stays valid
+// as a handle while the table grows and until the chunk is erased
+class ChunkMap
+{
+private:
+    class Slot
+    {
+    public:
+        int64_t key;
+        // nullptr while the slot is free
+        uPtr<Chunk> chunk;
+    };
+    // a power of two, kept at most half full
+    std::vector<Slot> m_slots;
+    size_t m_mask;
+    size_t m_size;
+
+    // the home slot of a key, the key bits are mixed so neighboring chunks spread out
+    size_t home(int64_t key) const {
+        return (size_t)(((uint64_t)key * 0x9e3779b97f4a7c15ull) >> 32) & m_mask;
+    }
+    void grow();
+
+public:
+    // visits the loaded chunks in table order
+    class Iterator
+    {
+    private:
+        const Slot* m_slot;
+        const Slot* m_end;
+    public:
+        Iterator(const Slot* slot, const Slot* end): m_slot(slot), m_end(end) {
+            while (m_slot != m_end && m_slot->chunk == nullptr) {
+                m_slot++;
+            }
+        }
+        Chunk& operator*() const { return *(m_slot->chunk); }
+        Iterator& operator++() {
+            do {
+                m_slot++;
+            } while (m_slot != m_end && m_slot->chunk == nullptr);
+            return *this;
+        }
+        bool operator!=(const Iterator& other) const { return m_slot != other.m_slot; }
+    };
+
+    ChunkMap();
+    ~ChunkMap();
+
+    // the chunk of a key, nullptr when it is not loaded
+    Chunk* find(int64_t key) const {
+        for (size_t i = home(key); ; i = (i + 1) & m_mask) {
+            const Slot& slot = m_slots[i];
+            if (slot.chunk == nullptr) {
+                return nullptr;
+            }
+            if (slot.key == key) {
+                return slot.chunk.get();
+            }
+        }
+    }
+    bool contains(int64_t key) const { return find(key) != nullptr; }
+    // add a chunk under a key and return it, or return the chunk already there
+    Chunk* insert(int64_t key, uPtr<Chunk> chunk);
+    // remove and free the chunk of a key
+    void erase(int64_t key);
+    size_t size() const { return m_size; }
+
+    Iterator begin() const { return Iterator(m_slots.data(), m_slots.data() + m_slots.size()); }
+    Iterator end() const {
+        const Slot* end = m_slots.data() + m_slots.size();
+        return Iterator(end, end);
+    }
+};
+
+#endif // CHUNKMAP_H
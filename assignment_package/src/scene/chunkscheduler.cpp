@@ -0,0 +1,161 @@
+#include "chunkscheduler.h"
+#include <algorithm>
+#include <iostream>
+
+//#define PRINT_LOAD_METRICS
+
+float ChunkScheduler::loadRadius = 80.f;
+float ChunkScheduler::prefetchSeconds = 2.f;
+float ChunkScheduler::behindWeight = 1.5f;
+float ChunkScheduler::unloadMargin = 48.f;
+
+// cosine of the half angle of view counted as in view, a bit wider than the camera
+static const float VIEW_COS = 0.5f;
+// chunks this close are needed whichever way the camera faces
+static const float NEAR_DISTANCE = 24.f;
+// chunks streaming in are kept until this far out of range
+static const float CANCEL_MARGIN = 32.f;
+// weight of the newest frame in the smoothed velocity and time to visible
+static const float SMOOTHING = 0.2f;
+
+ChunkScheduler::ChunkScheduler(Terrain* terrain):
+    mp_terrain(terrain), m_pos(0.f), m_look(0.f, 1.f), m_velocity(0.f), m_tracking(false),
+    m_queueDepth(0), m_requested(), m_timeToVisible(0.f), m_maxTimeToVisible(0.f)
+{}
+
+// follow the player, once per frame
+void ChunkScheduler::update(const glm::vec3 &pos, const glm::vec3 &look, float elapsedMs) {
+    glm::vec2 pos2(pos.x, pos.z);
+    if (m_tracking && elapsedMs > 0.f) {
+        glm::vec2 velocity = (pos2 - m_pos) / (elapsedMs * 0.001f);
+        m_velocity = glm::mix(m_velocity, velocity, SMOOTHING);
+    }
+    m_pos = pos2;
+    m_tracking = true;
+    glm::vec2 look2(look.x, look.z);
+    // looking straight up or down, keep the last direction
+    if (glm::length(look2) > 0.01f) {
+        m_look = glm::normalize(look2);
+    }
+}
+
+// where the player will be after prefetchSeconds, at most loadRadius away
+glm::vec2 ChunkScheduler::predicted() const {
+    glm::vec2 ahead = m_velocity * prefetchSeconds;
+    float length = glm::length(ahead);
+    if (length > loadRadius) {
+        ahead *= loadRadius / length;
+    }
+    return m_pos + ahead;
+}
+
+// the priority of a chunk for the current view, smaller is more urgent
+float ChunkScheduler::priority(const Rect16 &rect) const {
+    glm::vec2 center(rect.xmin + 8.f, rect.zmin + 8.f);
+    glm::vec2 offset = center - m_pos;
+    float distance = glm::length(offset);
+    // count a chunk ahead of the player by its distance to the predicted position
+    distance = std::min(distance, glm::length(center - predicted()));
+    if (distance < NEAR_DISTANCE) {
+        return distance;
+    }
+    // chunks in view keep their distance, the others count farther the more they face away
+    float facing = glm::dot(offset / glm::length(offset), m_look);
+    if (facing >= VIEW_COS) {
+        return distance;
+    }
+    return distance * (1.f + behindWeight * (VIEW_COS - facing) / (VIEW_COS + 1.f));
+}
+
+// hand out up to count missing chunks, most urgent first, and mark them pending
+void ChunkScheduler::request(size_t count, std::vector<ChunkRequest> &result) {
+    // every chunk within the load radius of the player or the predicted position
+    glm::vec2 ahead = predicted();
+    int x0 = (int)floorf(std::min(m_pos.x, ahead.x) - loadRadius);
+    int z0 = (int)floorf(std::min(m_pos.y, ahead.y) - loadRadius);
+    int x1 = (int)ceilf(std::max(m_pos.x, ahead.x) + loadRadius);
+    int z1 = (int)ceilf(std::max(m_pos.y, ahead.y) + loadRadius);
+    mp_terrain->moveToOrigin(x0, z0);
+    std::vector<ChunkRequest> missing;
+    for (int x = x0; x <= x1; x += 16) {
+        for (int z = z0; z <= z1; z += 16) {
+            glm::vec2 center(x + 8.f, z + 8.f);
+            if (glm::length(center - m_pos) > loadRadius &&
+                glm::length(center - ahead) > loadRadius) {
+                continue;
+            }
+            if (mp_terrain->hasChunk(x, z) || mp_terrain->m_pending.count(mp_terrain->hash(x, z))) {
+                continue;
+            }
+            Rect16 rect(x, z);
+            missing.push_back(ChunkRequest(rect, priority(rect)));
+        }
+    }
+    size_t n = std::min(count, missing.size());
+    std::partial_sort(missing.begin(), missing.begin() + n, missing.end(),
+                      [](const ChunkRequest &a, const ChunkRequest &b) {
+        return a.priority < b.priority;
+    });
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < n; i++) {
+        int64_t key = mp_terrain->hash(missing[i].rect.xmin, missing[i].rect.zmin);
+        mp_terrain->m_pending.insert(key);
+        m_requested[key] = now;
+        result.push_back(missing[i]);
+    }
+    m_queueDepth = (int)(missing.size() - n);
+}
+
+// whether a chunk streaming in is no longer wanted
+bool ChunkScheduler::outOfRange(const Rect16 &rect) const {
+    glm::vec2 center(rect.xmin + 8.f, rect.zmin + 8.f);
+    float range = loadRadius + CANCEL_MARGIN;
+    return glm::length(center - m_pos) > range && glm::length(center - predicted()) > range;
+}
+
+// find up to count loaded chunks beyond the unload radius, farthest first
+void ChunkScheduler::unloadable(size_t count, std::vector<Rect16> &result) const {
+    glm::vec2 ahead = predicted();
+    float range = loadRadius + unloadMargin;
+    std::vector<ChunkRequest> far;
+    for (Chunk& chunk : mp_terrain->m_chunks) {
+        glm::vec4 origin = chunk.packedOrigin();
+        glm::vec2 center(origin.x + 8.f, origin.z + 8.f);
+        float distance = std::min(glm::length(center - m_pos), glm::length(center - ahead));
+        if (distance > range) {
+            far.push_back(ChunkRequest(Rect16((int)origin.x, (int)origin.z), -distance));
+        }
+    }
+    size_t n = std::min(count, far.size());
+    std::partial_sort(far.begin(), far.begin() + n, far.end(),
+                      [](const ChunkRequest &a, const ChunkRequest &b) {
+        return a.priority < b.priority;
+    });
+    for (size_t i = 0; i < n; i++) {
+        result.push_back(far[i].rect);
+    }
+}
+
+// a requested chunk was dropped, it may be requested again
+void ChunkScheduler::cancelled(const Rect16 &rect) {
+    int64_t key = mp_terrain->hash(rect.xmin, rect.zmin);
+    mp_terrain->m_pending.erase(key);
+    m_requested.erase(key);
+}
+
+// a requested chunk got its mesh on the gpu
+void ChunkScheduler::visible(const Rect16 &rect) {
+    auto it = m_requested.find(mp_terrain->hash(rect.xmin, rect.zmin));
+    if (it == m_requested.end()) {
+        return;
+    }
+    float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - it->second).count();
+    m_requested.erase(it);
+    m_timeToVisible = m_timeToVisible == 0.f ? ms : glm::mix(m_timeToVisible, ms, SMOOTHING);
+    m_maxTimeToVisible = std::max(m_maxTimeToVisible, ms);
+#ifdef PRINT_LOAD_METRICS
+    std::cout << "chunk visible after " << ms << " ms\tsmoothed: " << m_timeToVisible <<
+                 " ms\tworst: " << m_maxTimeToVisible << " ms\tqueued: " << m_queueDepth <<
+                 "\tin flight: " << m_requested.size() << std::endl;
+#endif
+}
@@ -0,0 +1,81 @@
+#ifndef CHUNKSCHEDULER_H
+#define CHUNKSCHEDULER_H
+
+#include <chrono>
+#include <map>
+#include <vector>
+#include "terrain.h"
+
+// a missing chunk to load, smaller priorities load first
+class ChunkRequest
+{
+public:
+    Rect16 rect;
+    float priority;
+public:
+    ChunkRequest(const Rect16 &r, float p): rect(r), priority(p) {}
+};
+
+// decides which missing chunks around the player to load next, closest first,
+// chunks in view before those behind the camera, and ahead along the player's
+// motion so flying fast does not outrun generation
+class ChunkScheduler
+{
+private:
+    Terrain* mp_terrain;
+    // the player's xz position, view direction and velocity in blocks per second
+    glm::vec2 m_pos;
+    glm::vec2 m_look;
+    glm::vec2 m_velocity;
+    bool m_tracking;
+    // missing chunks in range that were left waiting by the last request
+    int m_queueDepth;
+    // when every chunk still streaming in was requested, by chunk hash
+    std::map<int64_t, std::chrono::steady_clock::time_point> m_requested;
+    // milliseconds from request to visible, smoothed and the worst seen
+    float m_timeToVisible;
+    float m_maxTimeToVisible;
+
+public:
+    // chunks within this many blocks of the player are loaded
+    static float loadRadius;
+    // chunks around where the player will be this many seconds ahead are prefetched
+    static float prefetchSeconds;
+    // how many times farther a chunk straight behind the camera counts
+    static float behindWeight;
+    // chunks are unloaded this many blocks beyond the load radius, so a chunk
+    // at the edge is not loaded and unloaded over and over
+    static float unloadMargin;
+
+public:
+    ChunkScheduler(Terrain* terrain);
+
+    // follow the player, once per frame
+    void update(const glm::vec3 &pos, const glm::vec3 &look, float elapsedMs);
+    // hand out up to count missing chunks, most urgent first, and mark them pending
+    void request(size_t count, std::vector<ChunkRequest> &result);
+    // the priority of a chunk for the current view, smaller is more urgent
+    float priority(const Rect16 &rect) const;
+    // whether a chunk streaming in is no longer wanted
+    bool outOfRange(const Rect16 &rect) const;
+    // find up to count loaded chunks beyond the unload radius, farthest first
+    void unloadable(size_t count, std::vector<Rect16> &result) const;
+    // a requested chunk was dropped, it may be requested again
+    void cancelled(const Rect16 &rect);
+    // a requested chunk got its mesh on the gpu
+    void visible(const Rect16 &rect);
+
+    // missing chunks in range waiting to be requested
+    int queueDepth() const { return m_queueDepth; }
+    // chunks requested and not yet visible
+    int inFlight() const { return (int)m_requested.size(); }
+    // smoothed and worst milliseconds from request to visible
+    float timeToVisible() const { return m_timeToVisible; }
+    float maxTimeToVisible() const { return m_maxTimeToVisible; }
+
+private:
+    // where the player will be after prefetchSeconds, at most loadRadius away
+    glm::vec2 predicted() const;
+};
+
+#endif // CHUNKSCHEDULER_H
@@ -0,0 +1,66 @@
+#include "chunksnapshot.h"
+
+ChunkSnapshot::ChunkSnapshot() :
+    m_blocks(18 * 18 * 258, EMPTY)
+{
+    std::fill(m_states, m_states + CHUNK_SECTIONS, SECTION_EMPTY);
+}
+
+// copy the blocks of a chunk and the border from its current neighbors
+void ChunkSnapshot::capture(const Chunk& chunk) {
+    std::fill(m_blocks.begin(), m_blocks.end(), EMPTY);
+    for (int section = 0; section < CHUNK_SECTIONS; section++) {
+        m_states[section] = chunk.sectionState(section);
+        const BlockSection& blocks = chunk.m_sections[section];
+        for (int y = section * 16; y < section * 16 + 16; y++) {
+            for (int z = 0; z < 16; z++) {
+                BlockType* row = &m_blocks[index(0, y, z)];
+                if (blocks.isUniform()) {
+                    std::fill(row, row + 16, blocks.get(0));
+                    continue;
+                }
+                int i = chunk.getIndex(0, y, z);
+                for (int x = 0; x < 16; x++) {
+                    row[x] = blocks.get(i + x);
+                }
+            }
+        }
+    }
+    for (int i = 0; i < 16; i++) {
+        captureColumn(chunk.left, 15, i, -1, i);
+        captureColumn(chunk.right, 0, i, 16, i);
+        captureColumn(chunk.back, i, 15, i, -1);
+        captureColumn(chunk.front, i, 0, i, 16);
+    }
+    // the diagonal neighbors can be reached through either side
+    const Chunk* leftBack = chunk.left ? chunk.left->back : (chunk.back ? chunk.back->left : nullptr);
+    const Chunk* leftFront = chunk.left ? chunk.left->front : (chunk.front ? chunk.front->left : nullptr);
+    const Chunk* rightBack = chunk.right ? chunk.right->back : (chunk.back ? chunk.back->right : nullptr);
+    const Chunk* rightFront = chunk.right ? chunk.right->front : (chunk.front ? chunk.front->right : nullptr);
+    captureColumn(leftBack, 15, 15, -1, -1);
+    captureColumn(leftFront, 15, 0, -1, 16);
+    captureColumn(rightBack, 0, 15, 16, -1);
+    captureColumn(rightFront, 0, 0, 16, 16);
+}
+
+// copy a column of a neighbor into the border
+void ChunkSnapshot::captureColumn(const Chunk* chunk, int xFrom, int zFrom, int x, int z) {
+    if (chunk == nullptr) {
+        return;
+    }
+    for (int y = 0; y < 256; y++) {
+        m_blocks[index(x, y, z)] = chunk->blockAt(xFrom, y, zFrom);
+    }
+}
+
+// get a row of blocks along x as bitmasks, bit x is set
+// when the block at (x, y, z) is opaque or is not empty
+void ChunkSnapshot::rowMasks(int y, int z, uint16_t& opaque, uint16_t& filled) const {
+    const BlockType* row = &m_blocks[index(0, y, z)];
+    opaque = 0;
+    filled = 0;
+    for (int x = 0; x < 16; x++) {
+        opaque |= (Chunk::isOpaqueType(row[x]) ? 1 : 0) << x;
+        filled |= (row[x] != EMPTY ? 1 : 0) << x;
+    }
+}
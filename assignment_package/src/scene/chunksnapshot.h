@@ -0,0 +1,39 @@
+#ifndef CHUNKSNAPSHOT_H
+#define CHUNKSNAPSHOT_H
+#include "chunk.h"
+
+// a copy of the blocks of a chunk with a one block border taken from its
+// neighbors (diagonals included), x and z run from -1 to 16 and y from -1 to 256,
+// the mesher reads only from this, so it never follows neighbor pointers, never
+// checks for borders and can run on any thread while the chunk is edited
+class ChunkSnapshot
+{
+private:
+    // 18 x 18 blocks per layer, layer by layer along y,
+    // outside the world and missing neighbors are EMPTY
+    std::vector<BlockType> m_blocks;
+    SectionState m_states[CHUNK_SECTIONS];
+
+    static int index(int x, int y, int z) {
+        return (x + 1) + (z + 1) * 18 + (y + 1) * 18 * 18;
+    }
+    // copy a column of a neighbor into the border
+    void captureColumn(const Chunk* chunk, int xFrom, int zFrom, int x, int z);
+
+public:
+    ChunkSnapshot();
+    // copy the blocks of a chunk and the border from its current neighbors
+    void capture(const Chunk& chunk);
+    BlockType at(int x, int y, int z) const {
+        return m_blocks[index(x, y, z)];
+    }
+    // whether a section was empty, filled with a single type or mixed
+    SectionState sectionState(int section) const {
+        return m_states[section];
+    }
+    // get a row of blocks along x as bitmasks, bit x is set
+    // when the block at (x, y, z) is opaque or is not empty
+    void rowMasks(int y, int z, uint16_t& opaque, uint16_t& filled) const;
+};
+
+#endif // CHUNKSNAPSHOT_H
@@ -0,0 +1,78 @@
+#include "climatefield.h"
+
+// areas kept before the cache is emptied, far more than the loaded chunks touch
+static const size_t CLIMATE_MAX_AREAS = 1024;
+
+ClimateField::ClimateField(const noise::fbmParams &moisturePars,
+                           const noise::fbmParams &temperaturePars) :
+    m_moisturePars(moisturePars), m_temperaturePars(temperaturePars), m_mutex(), m_areas()
+{}
+
+// the samples of the area with an origin, computed when not cached
+sPtr<const ClimateField::Area> ClimateField::area(int ax, int az) {
+    int64_t key = (int64_t(ax) << 32) + uint32_t(az);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_areas.find(key);
+        if (it != m_areas.end()) {
+            return it->second;
+        }
+    }
+    // sampled outside the lock, when two threads race for an area both get equal samples
+    sPtr<Area> samples = mkS<Area>();
+    for (int j = 0; j < CLIMATE_SAMPLES; j++) {
+        for (int i = 0; i < CLIMATE_SAMPLES; i++) {
+            int x = ax + i * CLIMATE_STEP;
+            int z = az + j * CLIMATE_STEP;
+            samples->moisture[j * CLIMATE_SAMPLES + i] = noise::sealedFbm2D(x, z, m_moisturePars);
+            samples->temperature[j * CLIMATE_SAMPLES + i] = noise::sealedFbm2D(x, z, m_temperaturePars);
+        }
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_areas.size() >= CLIMATE_MAX_AREAS) {
+        m_areas.clear();
+    }
+    m_areas[key] = samples;
+    return samples;
+}
+
+// bilinear interpolation of the samples around a column of an area
+static float interpolate(const float *samples, int lx, int lz) {
+    int i = lx / CLIMATE_STEP;
+    int j = lz / CLIMATE_STEP;
+    float fx = (float)(lx % CLIMATE_STEP) / CLIMATE_STEP;
+    float fz = (float)(lz % CLIMATE_STEP) / CLIMATE_STEP;
+    const float *row0 = samples + j * CLIMATE_SAMPLES + i;
+    const float *row1 = row0 + CLIMATE_SAMPLES;
+    return noise::mix(noise::mix(row0[0], row0[1], fx), noise::mix(row1[0], row1[1], fx), fz);
+}
+
+// the moisture and temperature noise at a column
+void ClimateField::sample(int x, int z, float &moisture, float &temperature) {
+    int ax = x & -CLIMATE_AREA;
+    int az = z & -CLIMATE_AREA;
+    sPtr<const Area> samples = area(ax, az);
+    moisture = interpolate(samples->moisture, x - ax, z - az);
+    temperature = interpolate(samples->temperature, x - ax, z - az);
+}
+
+// the moisture and temperature noise of the w x h columns from (x0, z0), row by row along x,
+// looking up each area the block covers once
+void ClimateField::grid(int x0, int z0, int w, int h, float *moisture, float *temperature) {
+    for (int az = z0 & -CLIMATE_AREA; az < z0 + h; az += CLIMATE_AREA) {
+        for (int ax = x0 & -CLIMATE_AREA; ax < x0 + w; ax += CLIMATE_AREA) {
+            sPtr<const Area> samples = area(ax, az);
+            int xmin = std::max(x0, ax);
+            int zmin = std::max(z0, az);
+            int xmax = std::min(x0 + w, ax + CLIMATE_AREA);
+            int zmax = std::min(z0 + h, az + CLIMATE_AREA);
+            for (int z = zmin; z < zmax; z++) {
+                for (int x = xmin; x < xmax; x++) {
+                    int k = (z - z0) * w + (x - x0);
+                    moisture[k] = interpolate(samples->moisture, x - ax, z - az);
+                    temperature[k] = interpolate(samples->temperature, x - ax, z - az);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,178 @@
+#include "faceculling.h"
+#include "chunksnapshot.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FACECULLING_SSE2
+#include <emmintrin.h>
+#endif
+
+// the 16 rows of a layer, 256 bits, in one AVX2 register, two SSE2 registers
+// or a plain array when neither is available
+#if defined(__AVX2__)
+typedef __m256i RowPack;
+static inline RowPack loadRows(const uint16_t* p) {
+    return _mm256_loadu_si256((const __m256i*)p);
+}
+static inline void storeRows(uint16_t* p, RowPack a) {
+    _mm256_storeu_si256((__m256i*)p, a);
+}
+static inline RowPack orRows(RowPack a, RowPack b) {
+    return _mm256_or_si256(a, b);
+}
+// a & ~b
+static inline RowPack andNotRows(RowPack a, RowPack b) {
+    return _mm256_andnot_si256(b, a);
+}
+static inline RowPack shiftLeft1(RowPack a) {
+    return _mm256_slli_epi16(a, 1);
+}
+static inline RowPack shiftRight1(RowPack a) {
+    return _mm256_srli_epi16(a, 1);
+}
+#elif defined(FACECULLING_SSE2)
+struct RowPack {
+    __m128i lo;
+    __m128i hi;
+};
+static inline RowPack loadRows(const uint16_t* p) {
+    return {_mm_loadu_si128((const __m128i*)p), _mm_loadu_si128((const __m128i*)(p + 8))};
+}
+static inline void storeRows(uint16_t* p, RowPack a) {
+    _mm_storeu_si128((__m128i*)p, a.lo);
+    _mm_storeu_si128((__m128i*)(p + 8), a.hi);
+}
+static inline RowPack orRows(RowPack a, RowPack b) {
+    return {_mm_or_si128(a.lo, b.lo), _mm_or_si128(a.hi, b.hi)};
+}
+// a & ~b
+static inline RowPack andNotRows(RowPack a, RowPack b) {
+    return {_mm_andnot_si128(b.lo, a.lo), _mm_andnot_si128(b.hi, a.hi)};
+}
+static inline RowPack shiftLeft1(RowPack a) {
+    return {_mm_slli_epi16(a.lo, 1), _mm_slli_epi16(a.hi, 1)};
+}
+static inline RowPack shiftRight1(RowPack a) {
+    return {_mm_srli_epi16(a.lo, 1), _mm_srli_epi16(a.hi, 1)};
+}
+#else
+struct RowPack {
+    uint16_t rows[16];
+};
+static inline RowPack loadRows(const uint16_t* p) {
+    RowPack a;
+    for (int i = 0; i < 16; i++) {
+        a.rows[i] = p[i];
+    }
+    return a;
+}
+static inline void storeRows(uint16_t* p, RowPack a) {
+    for (int i = 0; i < 16; i++) {
+        p[i] = a.rows[i];
+    }
+}
+static inline RowPack orRows(RowPack a, RowPack b) {
+    for (int i = 0; i < 16; i++) {
+        a.rows[i] |= b.rows[i];
+    }
+    return a;
+}
+// a & ~b
+static inline RowPack andNotRows(RowPack a, RowPack b) {
+    for (int i = 0; i < 16; i++) {
+        a.rows[i] &= ~b.rows[i];
+    }
+    return a;
+}
+static inline RowPack shiftLeft1(RowPack a) {
+    for (int i = 0; i < 16; i++) {
+        a.rows[i] <<= 1;
+    }
+    return a;
+}
+static inline RowPack shiftRight1(RowPack a) {
+    for (int i = 0; i < 16; i++) {
+        a.rows[i] >>= 1;
+    }
+    return a;
+}
+#endif
+
+// cull the faces of the snapshot from y0 up to y0 + height
+void FaceCulling::build(const ChunkSnapshot& blocks, int y0, int height) {
+    m_y0 = y0;
+    m_height = height;
+    gather(blocks);
+    cull();
+}
+
+// copy the rows of the snapshot, its border included
+void FaceCulling::gather(const ChunkSnapshot& blocks) {
+    int layers = m_height + 2;
+    m_opaque.resize(layers * 18);
+    m_filled.resize(layers * 18);
+    m_leftOpaque.resize(m_height * 16);
+    m_leftFilled.resize(m_height * 16);
+    m_rightOpaque.resize(m_height * 16);
+    m_rightFilled.resize(m_height * 16);
+    // the snapshot is padded below, above and around the chunk,
+    // so every row and border block is there to read
+    for (int l = 0; l < layers; l++) {
+        int y = m_y0 + l - 1;
+        uint16_t* opaque = &m_opaque[l * 18];
+        uint16_t* filled = &m_filled[l * 18];
+        for (int z = -1; z <= 16; z++) {
+            blocks.rowMasks(y, z, opaque[z + 1], filled[z + 1]);
+        }
+        if (l == 0 || l == layers - 1) {
+            continue;
+        }
+        for (int z = 0; z < 16; z++) {
+            int i = (l - 1) * 16 + z;
+            BlockType left = blocks.at(-1, y, z);
+            BlockType right = blocks.at(16, y, z);
+            m_leftOpaque[i] = Chunk::isOpaqueType(left) ? 1 : 0;
+            m_leftFilled[i] = left != EMPTY ? 1 : 0;
+            m_rightOpaque[i] = Chunk::isOpaqueType(right) ? 0x8000 : 0;
+            m_rightFilled[i] = right != EMPTY ? 0x8000 : 0;
+        }
+    }
+}
+
+// cull the faces of every layer, an opaque block shows the faces next to
+// blocks that are not opaque, any other block the faces next to empty blocks
+void FaceCulling::cull() {
+    for (int face = 0; face < 6; face++) {
+        m_visible[face].resize(m_height * 16);
+    }
+    for (int l = 1; l <= m_height; l++) {
+        const uint16_t* opaqueRows = &m_opaque[l * 18];
+        const uint16_t* filledRows = &m_filled[l * 18];
+        RowPack opaque = loadRows(opaqueRows + 1);
+        RowPack filled = loadRows(filledRows + 1);
+        RowPack transparent = andNotRows(filled, opaque);
+        int out = (l - 1) * 16;
+        // neighbors along x come from shifting the rows, plus the border bit
+        RowPack nOpaque[6];
+        RowPack nFilled[6];
+        nOpaque[LEFT] = orRows(shiftLeft1(opaque), loadRows(&m_leftOpaque[out]));
+        nFilled[LEFT] = orRows(shiftLeft1(filled), loadRows(&m_leftFilled[out]));
+        nOpaque[RIGHT] = orRows(shiftRight1(opaque), loadRows(&m_rightOpaque[out]));
+        nFilled[RIGHT] = orRows(shiftRight1(filled), loadRows(&m_rightFilled[out]));
+        // neighbors along z are the rows before and after, along y the layers below and above
+        nOpaque[BACK] = loadRows(opaqueRows);
+        nFilled[BACK] = loadRows(filledRows);
+        nOpaque[FRONT] = loadRows(opaqueRows + 2);
+        nFilled[FRONT] = loadRows(filledRows + 2);
+        nOpaque[BOTTOM] = loadRows(opaqueRows - 18 + 1);
+        nFilled[BOTTOM] = loadRows(filledRows - 18 + 1);
+        nOpaque[TOP] = loadRows(opaqueRows + 18 + 1);
+        nFilled[TOP] = loadRows(filledRows + 18 + 1);
+        for (int face = 0; face < 6; face++) {
+            RowPack visible = orRows(andNotRows(opaque, nOpaque[face]),
+                                     andNotRows(transparent, nFilled[face]));
+            storeRows(&m_visible[face][out], visible);
+        }
+    }
+}
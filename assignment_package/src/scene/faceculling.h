@@ -0,0 +1,43 @@
+#ifndef FACECULLING_H
+#define FACECULLING_H
+#include <cstdint>
+#include <vector>
+
+class ChunkSnapshot;
+
+// face visibility of a slab of a chunk snapshot, found with bitmasks instead of
+// testing every face of every block with Chunk::shouldPaint,
+// each row holds 16 bits along x for one (y, z), a layer holds the 16 rows of one y,
+// so a whole layer is culled against its neighbors with a few shifts and and-nots
+class FaceCulling
+{
+private:
+    int m_y0;
+    int m_height;
+    // opaque and non-empty rows, padded with one layer below and above
+    // and with the rows of the back and front neighbors (18 rows per layer)
+    std::vector<uint16_t> m_opaque;
+    std::vector<uint16_t> m_filled;
+    // the blocks of the left (bit 0) and right (bit 15) neighbors next to each row
+    std::vector<uint16_t> m_leftOpaque;
+    std::vector<uint16_t> m_leftFilled;
+    std::vector<uint16_t> m_rightOpaque;
+    std::vector<uint16_t> m_rightFilled;
+    // visible faces, indexed by FaceType, 16 rows per layer
+    std::vector<uint16_t> m_visible[6];
+
+    // copy the rows of the snapshot, its border included
+    void gather(const ChunkSnapshot& blocks);
+    // cull the faces of every layer
+    void cull();
+
+public:
+    // cull the faces of the snapshot from y0 up to y0 + height
+    void build(const ChunkSnapshot& blocks, int y0, int height);
+    // the face of the block at (x, y, z) should be painted
+    bool visible(int face, int x, int y, int z) const {
+        return (m_visible[face][(y - m_y0) * 16 + z] >> x) & 1;
+    }
+};
+
+#endif // FACECULLING_H
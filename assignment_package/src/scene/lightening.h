@@ -20,8 +20,7 @@ private:
     void addFace(glm::vec4 pos0,
                  glm::vec4 pos1,
                  glm::vec4 nor,
-                 std::vector<glm::vec4>& verts,
-                 std::vector<GLuint>& idx) const;
+                 std::vector<glm::vec4>& verts) const;
 
 public:
     Lightening(OpenGLContext* context, glm::vec4 pos) : Drawable(context), m_originPos(pos) {}
@@ -0,0 +1,14 @@
+#include "noise.h"
+
+namespace noise {
+
+// new worlds use the hash backend, the terrain switches older ones back to sin
+Backend backend = HASH_BACKEND;
+uint32_t worldSeed = 0;
+
+// pcgHash of a few words, fixed at compile time
+static_assert(pcgHash(0u) == 129708002u && pcgHash(1u) == 2831084092u &&
+              pcgHash(12345u) == 4099845390u && pcgHash(0xdeadbeefu) == 1730779506u,
+              "pcgHash changed, hash backend worlds would generate differently");
+
+} // namespace noise
@@ -2,9 +2,26 @@
 #define NOISE_H
 
 #include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
 
 namespace noise {
 
+// where the random values behind all noise come from
+enum Backend : unsigned char
+{
+    // fract(sin(dot) * s3), the original one, kept for worlds saved with it,
+    // sinf differs between compilers and loses precision far from the origin
+    SIN_BACKEND,
+    // an integer hash of the exact bits of the inputs and the world seed
+    HASH_BACKEND
+};
+
+// set once by the terrain before the world is generated, defined in noise.cpp
+extern Backend backend;
+extern uint32_t worldSeed;
+
 struct fbmParams {
     float persistence = 0.5f;
     int octaves = 8;
@@ -65,11 +82,53 @@ static inline float area2D(float ax, float ay, float bx, float by) {
     return std::abs(ax * by - bx * ay) / 2.f;
 }
 
+// one round of the pcg output permutation, a cheap and well mixed 32 bit hash
+static constexpr inline uint32_t pcgHash(uint32_t v) {
+    uint32_t state = v * 747796405u + 2891336453u;
+    uint32_t word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+    return (word >> 22u) ^ word;
+}
+
+// the bits of a float, with -0 folded into 0
+static inline uint32_t floatBits(float f) {
+    f += 0.0f;
+    uint32_t bits;
+    std::memcpy(&bits, &f, sizeof(bits));
+    return bits;
+}
+
+// the hash of three seeds and the world seed, the start of every hashRand
+static inline uint32_t seedHash(float s1, float s2, float s3) {
+    uint32_t h = pcgHash(worldSeed ^ floatBits(s1));
+    h = pcgHash(h ^ floatBits(s2));
+    return pcgHash(h ^ floatBits(s3));
+}
+
+// hash two words on top of a seed hash to a value between [0,1),
+// made of the top 24 bits so the float is exact
+static inline float hashRand(uint32_t seeds, uint32_t a, uint32_t b) {
+    uint32_t h = pcgHash(seeds ^ a);
+    h = pcgHash(h ^ b);
+    return (float)(h >> 8) * (1.0f / 16777216.0f);
+}
+
 // get random value between (0,1) based on a 2D point
 static inline float rand2D(float x, float y, float s1, float s2, float s3) {
+    if (backend == HASH_BACKEND) {
+        return hashRand(seedHash(s1, s2, s3), floatBits(x), floatBits(y));
+    }
     return fractf(sinf(dot2D(x, y, s1, s2)) * s3);
 }
 
+// get random value between (0,1) of a block column, the sin backend
+// repeats every 1024 blocks to stay precise, the hash backend never does
+static inline float columnRand(int x, int z, float s1, float s2, float s3) {
+    if (backend == HASH_BACKEND) {
+        return hashRand(seedHash(s1, s2, s3), (uint32_t)x, (uint32_t)z);
+    }
+    return rand2D((float)(x % 1024), (float)(z % 1024), s1, s2, s3);
+}
+
 // get a random value between (0,1)
 static inline float rand1D(float seed) {
     return rand2D(seed, seed + 123.4f, seed + 345.6f, seed + 678.9f, seed + 987.6f);
@@ -121,6 +180,129 @@ static inline int sealedFbm2D(int x, int z, const fbmParams &p) {
                 p.exponent));
 }
 
+// the grid versions below give the same values as the scalar functions above,
+// which stay the reference, but evaluate a w x h block of columns at once,
+// each octave first computes the random values of the lattice points the block
+// interpolates between, once for all columns sharing them, then blends them for
+// every column in one pass, the low octaves of a block share a handful of points
+
+// x to the power Exponent, multiplied out like powf, a runtime exp when Exponent is 0
+template <int Exponent>
+static inline float powExp(float base, int exp) {
+    if (Exponent == 0) {
+        return powf(base, exp);
+    }
+    float result = 1.0f;
+    for (int i = 0; i < Exponent; i++) {
+        result *= base;
+    }
+    return result;
+}
+
+// the lattice coordinates one axis of a block interpolates between, in order,
+// with the index of the lower one and the fraction of every column
+static inline void latticeAxis(int c0, int n, int offset, float scale, float freq,
+                               std::vector<float> &lattice, int *lower, float *fract) {
+    lattice.clear();
+    for (int i = 0; i < n; i++) {
+        float v = (float)(c0 + i + offset) * scale * freq;
+        float cell = floorf(v);
+        fract[i] = fractf(v);
+        // columns only move forward along the axis, so the cell is new or the last one
+        if (lattice.empty() || lattice.back() < cell) {
+            lattice.push_back(cell);
+        }
+        if (lattice.back() == cell) {
+            lattice.push_back(cell + 1.0f);
+        }
+        lower[i] = (int)lattice.size() - 2;
+    }
+}
+
+// fbm2D of the columns of a w x h block from (x0, z0), row by row along x, scaled
+// and offset like sealedFbm2D, Octaves and Exponent are fixed at compile time
+// so common parameter sets get their own kernel, 0 takes them from the params
+template <int Octaves, int Exponent>
+void sealedFbmGrid(int x0, int z0, int w, int h, const fbmParams &p, int *out) {
+    int octaves = Octaves == 0 ? p.octaves : Octaves;
+    std::vector<float> total(w * h, 0.0f);
+    std::vector<float> latticeX, latticeZ, values;
+    std::vector<int> lowerX(w), lowerZ(h);
+    std::vector<float> fractX(w), fractZ(h);
+    uint32_t seeds = seedHash(p.seed1, p.seed2, p.seed3);
+    float freq = 1.0f;
+    float amp = 1.0f;
+    for (int o = 0; o < octaves; o++) {
+        freq *= 2.0f;
+        amp *= p.persistence;
+        latticeAxis(x0, w, p.offsetX, p.scaleX, freq, latticeX, lowerX.data(), fractX.data());
+        latticeAxis(z0, h, p.offsetZ, p.scaleZ, freq, latticeZ, lowerZ.data(), fractZ.data());
+        int nx = (int)latticeX.size();
+        int nz = (int)latticeZ.size();
+        values.resize(nx * nz);
+        for (int j = 0; j < nz; j++) {
+            float *row = values.data() + j * nx;
+            if (backend == HASH_BACKEND) {
+                uint32_t z = floatBits(latticeZ[j]);
+                for (int i = 0; i < nx; i++) {
+                    row[i] = hashRand(seeds, floatBits(latticeX[i]), z);
+                }
+            } else {
+                for (int i = 0; i < nx; i++) {
+                    row[i] = rand2D(latticeX[i], latticeZ[j], p.seed1, p.seed2, p.seed3);
+                }
+            }
+        }
+        for (int j = 0; j < h; j++) {
+            const float *row0 = values.data() + lowerZ[j] * nx;
+            const float *row1 = row0 + nx;
+            float *rowTotal = total.data() + j * w;
+            for (int i = 0; i < w; i++) {
+                int l = lowerX[i];
+                float i1 = mixCubic(row0[l], row0[l + 1], fractX[i]);
+                float i2 = mixCubic(row1[l], row1[l + 1], fractX[i]);
+                rowTotal[i] += mixCubic(i1, i2, fractZ[j]) * amp;
+            }
+        }
+    }
+    for (int i = 0; i < w * h; i++) {
+        out[i] = p.offsetY + (int)(p.scaleY * powExp<Exponent>(total[i], p.exponent));
+    }
+}
+
+// sealedFbm2D of the columns of a w x h block from (x0, z0), row by row along x,
+// using the kernel specialized for the octaves and exponent of the params if any
+static inline void sealedFbmGrid(int x0, int z0, int w, int h, const fbmParams &p, int *out) {
+    // the lattice walk needs the columns to move forward along both axes
+    if (p.scaleX <= 0.0f || p.scaleZ <= 0.0f) {
+        for (int j = 0; j < h; j++) {
+            for (int i = 0; i < w; i++) {
+                out[j * w + i] = sealedFbm2D(x0 + i, z0 + j, p);
+            }
+        }
+        return;
+    }
+    if (p.octaves == 8) {
+        switch (p.exponent) {
+        case 1:
+            sealedFbmGrid<8, 1>(x0, z0, w, h, p, out);
+            return;
+        case 3:
+            sealedFbmGrid<8, 3>(x0, z0, w, h, p, out);
+            return;
+        case 4:
+            sealedFbmGrid<8, 4>(x0, z0, w, h, p, out);
+            return;
+        case 5:
+            sealedFbmGrid<8, 5>(x0, z0, w, h, p, out);
+            return;
+        default:
+            break;
+        }
+    }
+    sealedFbmGrid<0, 0>(x0, z0, w, h, p, out);
+}
+
 } // namespace noise
 
 #endif // NOISE_H
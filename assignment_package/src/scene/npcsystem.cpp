@@ -2,6 +2,7 @@
 #include <glm/gtx/transform.hpp>
 #include <glm/gtx/euler_angles.hpp>
 #include "utils.h"
+#include "blockcursor.h"
 #include <iostream>
 
 void Hexahedron::populate(std::vector<GLuint> &idx, std::vector<float> &info) const {
@@ -126,20 +127,17 @@ void NPC::create() {
 }
 
 bool NPC::notCollidePosX(const glm::mat4 &newtrans) const {
-    glm::vec4 p0f = newtrans * glm::vec4(m_collider.pos[1], 1.f);
-    int p0[3] = {(int)floorf(p0f.x), (int)floorf(p0f.y), (int)floorf(p0f.z)};
-    glm::vec4 p1f = newtrans * glm::vec4(m_collider.pos[5], 1.f);
-    int p1[3] = {(int)floorf(p1f.x), (int)floorf(p1f.y), (int)floorf(p1f.z)};
-    glm::vec4 p2f = newtrans * glm::vec4(m_collider.pos[3], 1.f);
-    int p2[3] = {(int)floorf(p2f.x), (int)floorf(p2f.y), (int)floorf(p2f.z)};
-    glm::vec4 p3f = newtrans * glm::vec4(m_collider.pos[7], 1.f);
-    int p3[3] = {(int)floorf(p3f.x), (int)floorf(p3f.y), (int)floorf(p3f.z)};
-    return m_terrain->hasChunk(p0[0], p0[2]) && m_terrain->hasChunk(p1[0], p1[2]) &&
-           m_terrain->hasChunk(p2[0], p2[2]) && m_terrain->hasChunk(p3[0], p3[2]) &&
-           !Chunk::isCollidable(m_terrain->getBlockAt(p0[0], p0[1], p0[2])) &&
-           !Chunk::isCollidable(m_terrain->getBlockAt(p1[0], p1[1], p1[2])) &&
-           !Chunk::isCollidable(m_terrain->getBlockAt(p2[0], p2[1], p2[2])) &&
-           !Chunk::isCollidable(m_terrain->getBlockAt(p3[0], p3[1], p3[2]));
+    static const int corners[4] = {1, 5, 3, 7};
+    BlockCursor cursor(m_terrain);
+    for (int i = 0; i < 4; i++) {
+        glm::vec4 pf = newtrans * glm::vec4(m_collider.pos[corners[i]], 1.f);
+        int p[3] = {(int)floorf(pf.x), (int)floorf(pf.y), (int)floorf(pf.z)};
+        if (!cursor.hasChunk(p[0], p[2]) ||
+            Chunk::isCollidable(cursor.getBlockAt(p[0], p[1], p[2]))) {
+            return false;
+        }
+    }
+    return true;
 }
 
 glm::vec3 NPC::vecMoveAlongX(float amount) const {
@@ -164,8 +162,8 @@ bool NPC::canPassAlongX(float amount) const {
 
 bool NPC::canLiveAlongX(float amount, BiomeType biomeA, BiomeType biomeB) const {
     glm::vec3 newposition = m_position + vecMoveAlongX(amount);
-    Biome biome((int)floorf(newposition.x), (int)floorf(newposition.z));
-    BiomeType biomeType = biome.getBiome();
+    BiomeType biomeType = m_terrain->getBiomeAt((int)floorf(newposition.x),
+                                                 (int)floorf(newposition.z));
     return biomeType == biomeA || biomeType == biomeB;
 }
 
@@ -182,31 +180,29 @@ void NPC::doRotateAlongY(float angle) {
 }
 
 bool NPC::appendGravity(float deltaTime) {
+    static const int corners[4] = {0, 1, 4, 5};
     glm::vec3 newposition = m_position +
                             glm::vec3(0.f, -deltaTime / 1000.f * fallSpeed(), 0.f);
     glm::mat4 newtrans = glm::translate(newposition) *
                          glm::eulerAngleYXZ(m_rotation.y, m_rotation.x, m_rotation.z);
-    glm::vec4 p0f = newtrans * glm::vec4(m_collider.pos[0], 1.f);
-    int p0[3] = {(int)floorf(p0f.x), (int)floorf(p0f.y), (int)floorf(p0f.z)};
-    glm::vec4 p1f = newtrans * glm::vec4(m_collider.pos[1], 1.f);
-    int p1[3] = {(int)floorf(p1f.x), (int)floorf(p1f.y), (int)floorf(p1f.z)};
-    glm::vec4 p2f = newtrans * glm::vec4(m_collider.pos[4], 1.f);
-    int p2[3] = {(int)floorf(p2f.x), (int)floorf(p2f.y), (int)floorf(p2f.z)};
-    glm::vec4 p3f = newtrans * glm::vec4(m_collider.pos[5], 1.f);
-    int p3[3] = {(int)floorf(p3f.x), (int)floorf(p3f.y), (int)floorf(p3f.z)};
-    if (Chunk::isCollidable(m_terrain->getBlockAt(p0[0], p0[1], p0[2])) ||
-        Chunk::isCollidable(m_terrain->getBlockAt(p1[0], p1[1], p1[2])) ||
-        Chunk::isCollidable(m_terrain->getBlockAt(p2[0], p2[1], p2[2])) ||
-        Chunk::isCollidable(m_terrain->getBlockAt(p3[0], p3[1], p3[2])) ||
-        m_terrain->getBlockAt(p0[0], (int)floorf(p0f.y + floatHeight()), p0[2]) == WATER ||
-        m_terrain->getBlockAt(p1[0], (int)floorf(p1f.y + floatHeight()), p1[2]) == WATER ||
-        m_terrain->getBlockAt(p2[0], (int)floorf(p2f.y + floatHeight()), p2[2]) == WATER ||
-        m_terrain->getBlockAt(p3[0], (int)floorf(p3f.y + floatHeight()), p3[2]) == WATER) {
-        return false;
-    } else {
-        m_position = newposition;
-        return true;
+    // the block under each bottom corner, then the block it floats at
+    glm::ivec3 positions[8];
+    for (int i = 0; i < 4; i++) {
+        glm::vec4 pf = newtrans * glm::vec4(m_collider.pos[corners[i]], 1.f);
+        positions[i] = glm::ivec3((int)floorf(pf.x), (int)floorf(pf.y), (int)floorf(pf.z));
+        positions[i + 4] = glm::ivec3(positions[i].x, (int)floorf(pf.y + floatHeight()),
+                                      positions[i].z);
+    }
+    BlockType blocks[8];
+    BlockCursor cursor(m_terrain, positions[0].x, positions[0].z);
+    cursor.getBlocks(positions, 8, blocks);
+    for (int i = 0; i < 4; i++) {
+        if (Chunk::isCollidable(blocks[i]) || blocks[i + 4] == WATER) {
+            return false;
+        }
     }
+    m_position = newposition;
+    return true;
 }
 
 void NPC::wander(float deltaTime, float totalTime,
@@ -772,25 +768,20 @@ void NPCSystem::birthNPC(const Rect16 &scope) {
     int x = scope.xmid();
     int z = scope.zmid();
     // get random value
-    float seed = noise::rand2D((float)(x % 1024), (float)(z % 1024),
-                               123.4f, 345.6f, 456.7f) * 111.f;
+    float seed = noise::columnRand(x, z, 123.4f, 345.6f, 456.7f) * 111.f;
     float rand1 = noise::rand1D(seed);
     float rand2 = noise::rand1D(seed + 123.4);
     // get top height
-    int top = 255;
-    for (int y = 255; y >= 0; y--) {
-        if (Chunk::isCollidable(m_terrain->getBlockAt(x, y, z))) {
-            top = y;
-            break;
-        }
+    int top = m_terrain->getHeightAt(x, z);
+    if (top < 0) {
+        top = 255;
     }
     // compute npc root position
     float npcx = x + 0.5f;
     float npcy = top + 1.f;
     float npcz = z + 0.5f;
     // get biome type
-    Biome biome(x, z);
-    BiomeType biomeType = biome.getBiome();
+    BiomeType biomeType = m_terrain->getBiomeAt(x, z);
     // place npc based on biome type
     switch (biomeType) {
     case DARK:
@@ -838,6 +829,23 @@ void NPCSystem::update(float deltaTime) {
     }
 }
 
+// destroy the npcs that stand on a chunk that is no longer loaded
+void NPCSystem::removeUnloaded() {
+    for (unsigned int i = 0; i < npcs.size();) {
+        NPC *npc = npcs[i].get();
+        glm::vec3 pos = npc->position();
+        if (m_terrain->hasChunk((int)floorf(pos.x), (int)floorf(pos.z))) {
+            i++;
+            continue;
+        }
+        for (unsigned int j = 0; j < npc->size(); j++) {
+            npc->partAt(j)->destroy();
+        }
+        npcs[i] = std::move(npcs.back());
+        npcs.pop_back();
+    }
+}
+
 void NPCSystem::destroy() {
     for (unsigned int i = 0; i < npcs.size(); i++) {
         NPC *npc = npcs[i].get();
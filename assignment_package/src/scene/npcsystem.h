@@ -120,6 +120,8 @@ public:
     glm::mat4 partTrans(unsigned int index) const;
     // update the movement of this npc
     virtual void update(float deltaTime, float totalTime) = 0;
+    // get the world-space position of this npc
+    const glm::vec3& position() const { return m_position; }
 protected:
     // set vbo for all body parts
     void create();
@@ -262,6 +264,8 @@ public:
     void birthNPC(const Rect16 &scope);
     // update the movement of all the npcs
     void update(float deltaTime);
+    // destroy the npcs that stand on a chunk that is no longer loaded
+    void removeUnloaded();
     void destroy();
 };
 
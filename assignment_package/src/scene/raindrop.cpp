@@ -66,17 +66,9 @@ void RainDrop::setOriginPos(const glm::vec4 &pos)
 }
 
 void RainDrop::createRect(std::vector<glm::vec4>& verts,
-                          std::vector<GLint>& idx,
                           glm::vec4& pos,
                           glm::vec2& direction,
                           float offset, float height) {
-    int count = verts.size() / 4;
-    idx.push_back(count);
-    idx.push_back(count + 1);
-    idx.push_back(count + 2);
-    idx.push_back(count);
-    idx.push_back(count + 2);
-    idx.push_back(count + 3);
     direction = glm::normalize(direction);
 
     glm::vec4 nor(-direction.y, 0, -direction.x, 0);
@@ -102,14 +94,6 @@ void RainDrop::createRect(std::vector<glm::vec4>& verts,
 
     if (height > 0 && int(pos.x) % 2 == 0 && int(pos.z) % 2 == 0) {
         for (int i = 0; i < 3; i++) {
-            count = verts.size() / 4;
-            idx.push_back(count);
-            idx.push_back(count + 1);
-            idx.push_back(count + 2);
-            idx.push_back(count);
-            idx.push_back(count + 2);
-            idx.push_back(count + 3);
-
             verts.push_back(bpos);
             verts.push_back(nor);
             verts.push_back(bcolor);
@@ -144,29 +128,19 @@ void RainDrop::createRect(std::vector<glm::vec4>& verts,
 void RainDrop::create()
 {
     std::vector<glm::vec4> verts;
-    std::vector<GLint> idx;
 
     for (int i = 0; i < 16; i++) {
         for (int j = 0; j < 16; j++) {
             int index = i * 16 + j;
-            createRect(verts, idx, m_pos[index], m_direction[index], m_offset[index], m_height[index]);
+            createRect(verts, m_pos[index], m_direction[index], m_offset[index], m_height[index]);
         }
     }
 
 
-    count1 = idx.size();
-
-    // Create a VBO on our GPU and store its handle in bufIdx
-    generateIdx1();
-    // Tell OpenGL that we want to perform subsequent operations on the VBO referred to by bufIdx
-    // and that it will be treated as an element array buffer (since it will contain triangle indices)
-    context->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, bufIdx1);
-    // Pass the data stored in cyl_idx into the bound buffer, reading a number of bytes equal to
-    // SPH_IDX_COUNT multiplied by the size of a GLuint. This data is sent to the GPU to be read by shader programs.
-    context->glBufferData(GL_ELEMENT_ARRAY_BUFFER, idx.size() * sizeof(GLuint), idx.data(), GL_STATIC_DRAW);
+    // every rect is a quad of 4 vertices (16 vec4s), drawn with the shared quad indices
+    useSharedQuadIdx1(verts.size() / 16);
 
-    // The next few sets of function calls are basically the same as above, except bufPos and bufNor are
-    // array buffers rather than element array buffers, as they store vertex attributes like position.
+    // Create a VBO on our GPU and pass the vertices into it
     generateVer1();
     context->glBindBuffer(GL_ARRAY_BUFFER, bufVer1);
     context->glBufferData(GL_ARRAY_BUFFER, verts.size() * sizeof(glm::vec4), verts.data(), GL_STATIC_DRAW);
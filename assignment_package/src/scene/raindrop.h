@@ -25,7 +25,6 @@ private:
     std::vector<float> m_height;
     bool shouldBounced;
     void createRect(std::vector<glm::vec4>& verts,
-                    std::vector<GLint>& idx,
                     glm::vec4& pos,
                     glm::vec2& direction,
                     float offset, float height);
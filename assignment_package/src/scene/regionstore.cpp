@@ -0,0 +1,286 @@
+#include "regionstore.h"
+#include "chunk.h"
+#include <QByteArray>
+#include <QDir>
+#include <QSaveFile>
+#include <cstring>
+#include <iostream>
+
+// a region file starts with a magic number, a version, and for every chunk
+// the offset and size of its payload, all little-endian 32 bit words,
+// a payload is the output of qCompress for the bytes of Chunk::write
+static const char REGION_MAGIC[4] = {'M', 'M', 'R', 'G'};
+static const quint32 REGION_VERSION = 1;
+static const int REGION_SIZE = REGION_CHUNKS * REGION_CHUNKS;
+static const int REGION_HEADER = 8 + REGION_SIZE * 8;
+
+// the settings file of a world holds a magic number, a version, the noise backend
+// and the world seed, in the same little-endian words
+static const char SETTINGS_MAGIC[4] = {'M', 'M', 'W', 'D'};
+static const quint32 SETTINGS_VERSION = 1;
+static const int SETTINGS_SIZE = 13;
+
+static quint32 readWord(const uchar *bytes) {
+    return quint32(bytes[0]) | (quint32(bytes[1]) << 8) |
+            (quint32(bytes[2]) << 16) | (quint32(bytes[3]) << 24);
+}
+
+static void writeWord(QByteArray &out, int at, quint32 word) {
+    for (int i = 0; i < 4; i++) {
+        out[at + i] = char((word >> (i * 8)) & 0xff);
+    }
+}
+
+// map the file if it exists, return false otherwise
+bool RegionStore::Region::map() {
+    if (opened) {
+        return data != nullptr;
+    }
+    opened = true;
+    file = mkU<QFile>(path);
+    if (!file->open(QIODevice::ReadOnly) || file->size() < REGION_HEADER) {
+        file = nullptr;
+        return false;
+    }
+    size = file->size();
+    data = file->map(0, size);
+    if (data == nullptr || memcmp(data, REGION_MAGIC, 4) != 0 ||
+        readWord(data + 4) != REGION_VERSION) {
+        std::cerr << "ignoring invalid region file " << path.toStdString() << std::endl;
+        unmap();
+        opened = true;
+        return false;
+    }
+    return true;
+}
+
+void RegionStore::Region::unmap() {
+    if (file != nullptr) {
+        if (data != nullptr) {
+            file->unmap(const_cast<uchar*>(data));
+        }
+        file->close();
+    }
+    file = nullptr;
+    data = nullptr;
+    size = 0;
+    opened = false;
+}
+
+// the compressed payload of a chunk in the mapped file, false when there is none
+bool RegionStore::Region::payload(int index, const uchar *&bytes, quint32 &length) const {
+    if (data == nullptr) {
+        return false;
+    }
+    quint32 offset = readWord(data + 8 + index * 8);
+    length = readWord(data + 12 + index * 8);
+    if (length == 0 || offset < (quint32)REGION_HEADER || offset + (qint64)length > size) {
+        return false;
+    }
+    bytes = data + offset;
+    return true;
+}
+
+// the file holding the chunks being written together with the ones already in
+// the mapped file, only while writeMutex is held so the mapping stays in place
+QByteArray RegionStore::Region::assemble() const {
+    QByteArray out(REGION_HEADER, 0);
+    memcpy(out.data(), REGION_MAGIC, 4);
+    writeWord(out, 4, REGION_VERSION);
+    for (int index = 0; index < REGION_SIZE; index++) {
+        auto it = writing.find(index);
+        QByteArray compressed;
+        const uchar *bytes = nullptr;
+        quint32 length = 0;
+        if (it != writing.end()) {
+            compressed = qCompress(it->second.data(), (int)it->second.size());
+            bytes = reinterpret_cast<const uchar*>(compressed.constData());
+            length = (quint32)compressed.size();
+        } else if (!payload(index, bytes, length)) {
+            continue;
+        }
+        writeWord(out, 8 + index * 8, (quint32)out.size());
+        writeWord(out, 12 + index * 8, length);
+        out.append(reinterpret_cast<const char*>(bytes), (int)length);
+    }
+    return out;
+}
+
+// the saved blocks of a chunk not written yet, nullptr when there are none,
+// the ones saved after a flush took the pending chunks come first
+const std::vector<uint8_t>* RegionStore::Region::unwritten(int index) const {
+    auto it = pending.find(index);
+    if (it != pending.end()) {
+        return &it->second;
+    }
+    it = writing.find(index);
+    if (it != writing.end()) {
+        return &it->second;
+    }
+    return nullptr;
+}
+
+// keep region files in a directory, created on the first write
+RegionStore::RegionStore(const QString &directory):
+    m_directory(directory), m_mutex(), m_regions(), m_pending(0)
+{}
+
+RegionStore::~RegionStore() {
+    for (auto it = m_regions.begin(); it != m_regions.end(); it++) {
+        it->second->unmap();
+    }
+}
+
+RegionStore::Region& RegionStore::region(int x, int z) {
+    int rx = x >> 9;
+    int rz = z >> 9;
+    int64_t key = (int64_t(rx) << 32) + uint32_t(rz);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_regions.find(key);
+    if (it == m_regions.end()) {
+        QString path = m_directory + QString("/r.%1.%2.region").arg(rx).arg(rz);
+        it = m_regions.emplace(std::make_pair(key, mkU<Region>(path))).first;
+    }
+    return *(it->second);
+}
+
+// index of a chunk origin inside its region
+static int regionIndex(int x, int z) {
+    return ((x >> 4) & (REGION_CHUNKS - 1)) + ((z >> 4) & (REGION_CHUNKS - 1)) * REGION_CHUNKS;
+}
+
+// read the saved blocks of the chunk at a chunk origin into a chunk,
+// from any thread, return false when it was never saved
+bool RegionStore::load(int x, int z, Chunk &chunk) {
+    Region& r = region(x, z);
+    int index = regionIndex(x, z);
+    std::lock_guard<std::mutex> lock(r.mutex);
+    const std::vector<uint8_t>* unwritten = r.unwritten(index);
+    if (unwritten != nullptr) {
+        return chunk.read(unwritten->data(), unwritten->size());
+    }
+    const uchar *bytes = nullptr;
+    quint32 length = 0;
+    if (!r.map() || !r.payload(index, bytes, length)) {
+        return false;
+    }
+    QByteArray raw = qUncompress(bytes, (int)length);
+    return chunk.read(reinterpret_cast<const uint8_t*>(raw.constData()), (size_t)raw.size());
+}
+
+// whether the chunk at a chunk origin was ever saved, from any thread
+bool RegionStore::contains(int x, int z) {
+    Region& r = region(x, z);
+    int index = regionIndex(x, z);
+    std::lock_guard<std::mutex> lock(r.mutex);
+    const uchar *bytes = nullptr;
+    quint32 length = 0;
+    return r.unwritten(index) != nullptr || (r.map() && r.payload(index, bytes, length));
+}
+
+// queue the blocks of the chunk at a chunk origin for writing
+void RegionStore::save(int x, int z, const Chunk &chunk) {
+    std::vector<uint8_t> raw;
+    chunk.write(raw);
+    Region& r = region(x, z);
+    std::lock_guard<std::mutex> lock(r.mutex);
+    std::vector<uint8_t>& slot = r.pending[regionIndex(x, z)];
+    if (slot.empty()) {
+        m_pending++;
+    }
+    slot.swap(raw);
+}
+
+// number of saved chunks that are not written yet
+int RegionStore::pendingCount() const {
+    return m_pending;
+}
+
+// write every region with saved chunks, from any thread
+void RegionStore::flush() {
+    std::vector<Region*> regions;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto it = m_regions.begin(); it != m_regions.end(); it++) {
+            regions.push_back(it->second.get());
+        }
+    }
+    QDir().mkpath(m_directory);
+    for (Region* r : regions) {
+        std::lock_guard<std::mutex> writeLock(r->writeMutex);
+        {
+            std::lock_guard<std::mutex> lock(r->mutex);
+            if (r->pending.empty()) {
+                continue;
+            }
+            r->writing.swap(r->pending);
+            r->map();
+        }
+        // compress and write without the lock, saving and loading go on meanwhile
+        QByteArray out = r->assemble();
+        QSaveFile saved(r->path);
+        bool written = saved.open(QIODevice::WriteOnly) && saved.write(out) == out.size();
+        std::lock_guard<std::mutex> lock(r->mutex);
+        if (written) {
+            // the old mapping must go before the new file takes its place
+            r->unmap();
+            written = saved.commit();
+        } else {
+            saved.cancelWriting();
+        }
+        if (written) {
+            m_pending -= (int)r->writing.size();
+        } else {
+            std::cerr << "failed to write region file " << r->path.toStdString() << std::endl;
+            // keep the chunks for the next flush, unless they were saved again meanwhile
+            for (auto it = r->writing.begin(); it != r->writing.end(); it++) {
+                if (r->pending.count(it->first)) {
+                    m_pending--;
+                } else {
+                    r->pending[it->first].swap(it->second);
+                }
+            }
+        }
+        r->writing.clear();
+    }
+}
+
+// whether the world was ever written
+bool RegionStore::exists() const {
+    return QDir(m_directory).exists();
+}
+
+// read the noise backend and seed the world was generated with,
+// return false when they were never saved
+bool RegionStore::loadSettings(uchar &backend, quint32 &seed) const {
+    QFile file(m_directory + "/world.dat");
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QByteArray bytes = file.readAll();
+    const uchar *data = reinterpret_cast<const uchar*>(bytes.constData());
+    if (bytes.size() < SETTINGS_SIZE || memcmp(data, SETTINGS_MAGIC, 4) != 0 ||
+        readWord(data + 4) != SETTINGS_VERSION) {
+        std::cerr << "ignoring invalid world settings in " << m_directory.toStdString() << std::endl;
+        return false;
+    }
+    backend = data[8];
+    seed = readWord(data + 9);
+    return true;
+}
+
+// save the noise backend and seed of a new world
+bool RegionStore::saveSettings(uchar backend, quint32 seed) {
+    QByteArray out(SETTINGS_SIZE, 0);
+    memcpy(out.data(), SETTINGS_MAGIC, 4);
+    writeWord(out, 4, SETTINGS_VERSION);
+    out[8] = char(backend);
+    writeWord(out, 9, seed);
+    QDir().mkpath(m_directory);
+    QSaveFile saved(m_directory + "/world.dat");
+    if (!saved.open(QIODevice::WriteOnly) || saved.write(out) != out.size()) {
+        saved.cancelWriting();
+        return false;
+    }
+    return saved.commit();
+}
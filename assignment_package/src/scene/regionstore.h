@@ -0,0 +1,91 @@
+#ifndef REGIONSTORE_H
+#define REGIONSTORE_H
+
+#include <QFile>
+#include <QString>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <vector>
+#include "smartpointerhelp.h"
+
+class Chunk;
+
+// chunks per side of a region file
+const int REGION_CHUNKS = 32;
+
+// saves chunks to disk in region files of 32 x 32 chunks, every file starts with
+// a table of the offset and size of each chunk's compressed payload,
+// files are read through a memory map from any thread, saved chunks wait in
+// memory until flush writes them in one batch per region, off the main thread
+class RegionStore
+{
+private:
+    class Region
+    {
+    public:
+        // guards everything below, a flush holds it only to take the pending chunks
+        // and to put the new file in place, not while compressing and writing
+        std::mutex mutex;
+        // held by a flush for its whole write, the mapping is not replaced meanwhile
+        std::mutex writeMutex;
+        QString path;
+        // the file and its mapping, opened on the first read after a write
+        uPtr<QFile> file;
+        const uchar* data;
+        qint64 size;
+        bool opened;
+        // saved chunks not written yet, by chunk index in the region
+        std::map<int, std::vector<uint8_t>> pending;
+        // the saved chunks a flush is writing, taken from pending
+        std::map<int, std::vector<uint8_t>> writing;
+
+        Region(const QString &path):
+            mutex(), writeMutex(), path(path), file(nullptr), data(nullptr), size(0),
+            opened(false), pending(), writing() {}
+        // map the file if it exists, return false otherwise
+        bool map();
+        void unmap();
+        // the compressed payload of a chunk in the mapped file, false when there is none
+        bool payload(int index, const uchar *&bytes, quint32 &length) const;
+        // the file holding the chunks being written together with the ones already in
+        // the mapped file, only while writeMutex is held
+        QByteArray assemble() const;
+        // the saved blocks of a chunk not written yet, nullptr when there are none
+        const std::vector<uint8_t>* unwritten(int index) const;
+    };
+    QString m_directory;
+    // guards the region map, not the regions
+    std::mutex m_mutex;
+    std::map<int64_t, uPtr<Region>> m_regions;
+    std::atomic<int> m_pending;
+
+    Region& region(int x, int z);
+
+public:
+    // keep region files in a directory, created on the first write
+    RegionStore(const QString &directory);
+    ~RegionStore();
+
+    // read the saved blocks of the chunk at a chunk origin into a chunk,
+    // from any thread, return false when it was never saved
+    bool load(int x, int z, Chunk &chunk);
+    // whether the chunk at a chunk origin was ever saved, from any thread
+    bool contains(int x, int z);
+    // queue the blocks of the chunk at a chunk origin for writing
+    void save(int x, int z, const Chunk &chunk);
+    // number of saved chunks that are not written yet
+    int pendingCount() const;
+    // write every region with saved chunks, from any thread
+    void flush();
+
+    // whether the world was ever written
+    bool exists() const;
+    // read the noise backend and seed the world was generated with,
+    // return false when they were never saved
+    bool loadSettings(uchar &backend, quint32 &seed) const;
+    // save the noise backend and seed of a new world
+    bool saveSettings(uchar backend, quint32 seed);
+};
+
+#endif // REGIONSTORE_H
@@ -23,7 +23,6 @@ private:
     std::vector<glm::vec2> m_velocity;
     int m_type;
     void createRect(std::vector<glm::vec4>& verts,
-                    std::vector<GLint>& idx,
                     glm::vec4& pos,
                     glm::vec2& direction,
                     glm::vec2& velocity);
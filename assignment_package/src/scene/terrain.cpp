@@ -1,47 +1,206 @@
 #include "terrain.h"
+#include <future>
+#include <iostream>
+#include <random>
+#include "jobsystem.h"
 
-// construct and initialize
+// region files of the saved world, relative to the working directory
+static const char* WORLD_DIRECTORY = "world";
+
+// construct and initialize, resuming the saved world where there is one
 Terrain::Terrain(OpenGLContext* context):
-    m_chunks(), m_context(context)
+    m_chunks(), m_pending(), m_explored(), m_context(context),
+    mp_store(mkU<RegionStore>(WORLD_DIRECTORY)), m_undecorated(), mp_decorating(nullptr)
 {
+    // set once up front, chunks are generated on many threads at once
+    Biome::InitializeParams();
+    // new worlds draw their noise from the hash backend under a fresh seed,
+    // worlds saved before the settings were kept stay on the sin backend
+    uchar backend = noise::HASH_BACKEND;
+    quint32 seed = 0;
+    if (!mp_store->loadSettings(backend, seed)) {
+        if (mp_store->exists()) {
+            backend = noise::SIN_BACKEND;
+        } else {
+            seed = std::random_device()();
+        }
+        if (!mp_store->saveSettings(backend, seed)) {
+            std::cerr << "failed to save the world settings" << std::endl;
+        }
+    }
+    noise::backend = backend == noise::SIN_BACKEND ? noise::SIN_BACKEND : noise::HASH_BACKEND;
+    noise::worldSeed = seed;
+    // the coarse climate came with the hash backend, old worlds keep the exact one
+    Biome::coarseClimate = noise::backend == noise::HASH_BACKEND;
+}
+
+// load the saved chunks of the first 64 x 64 area, then generate the others as a group
+// on the workers of a job system, and wait for them, both from one pass of biome maps
+void Terrain::createFirstArea(JobSystem &jobs)
+{
+    BiomeMap groupMaps[16];
+    BiomeMap::buildGroup(0, 0, 4, 4, groupMaps);
+    std::set<int64_t> generatedChunks;
     for (int x = 0; x < 64; x += 16) {
         for (int z = 0; z < 64; z += 16) {
-            m_chunks.emplace(std::make_pair(hash(x, z), Chunk(m_context, glm::vec4(x, 0, z, 1))));
+            uPtr<Chunk> loaded = loadChunk(x, z, &groupMaps[z / 16 * 4 + x / 16]);
+            if (loaded != nullptr) {
+                m_chunks.insert(hash(x, z), std::move(loaded));
+            } else {
+                generatedChunks.insert(hash(x, z));
+            }
+        }
+    }
+    buildFbmGroup(0, 0, groupMaps, jobs);
+    for (int x = 0; x < 64; x += 16) {
+        for (int z = 0; z < 64; z += 16) {
+            Chunk& chunk = *getChunk(x, z);
             buildWeather(x, z);
             setNeighbor(x, z);
-            buildChunk(x, z);
+            updateRainHeights(x, z);
+            bool generated = generatedChunks.count(hash(x, z)) > 0;
+            // chunks saved as their edits alone are decorated again as well
+            if (generated || chunk.awaitsReplay()) {
+                createCloud(x, z);
+                m_undecorated.push_back(Rect16(x, z));
+            }
         }
     }
+    m_explored.insert(hash(0, 0));
 }
 
 // get the blocktype at a world-space position
 // return empty when no block is there
 BlockType Terrain::getBlockAt(int x, int y, int z) const
 {
-    int xo = x;
-    int zo = z;
-    moveToOrigin(xo, zo);
+    int xo = x & -16;
+    int zo = z & -16;
+    const Chunk* chunk = m_chunks.find(hash(xo, zo));
     // this chunk has not been created yet
-    if (!m_chunks.count(hash(xo, zo))) {
+    if (chunk == nullptr) {
         return EMPTY;
     }
-    // get chunk and set block type
-    return m_chunks.find(hash(xo, zo))->second.blockAt(x - xo, y, z - zo);
+    return chunk->blockAt(x - xo, y, z - zo);
 }
 
 // set the blocktype at a world-space position
 // when there is no chunk, do nothing
 void Terrain::setBlockAt(int x, int y, int z, BlockType t)
 {
-    int xo = x;
-    int zo = z;
-    moveToOrigin(xo, zo);
+    int xo = x & -16;
+    int zo = z & -16;
+    Chunk* found = m_chunks.find(hash(xo, zo));
     // when there is no chunk, do nothing
-    if (m_chunks.find(hash(xo, zo)) == m_chunks.end()) {
+    if (found == nullptr) {
         return;
     }
-    // get chunk and set block type
-    m_chunks.find(hash(xo, zo))->second.blockAt(x - xo, y, z - zo) = t;
+    setBlockIn(*found, x, y, z, t);
+}
+
+// set the blocktype at a world-space position of the chunk holding it
+void Terrain::setBlockIn(Chunk &chunk, int x, int y, int z, BlockType t) {
+    chunk.setBlockAt(x & 15, y, z & 15, t);
+    // assets reaching in from a neighbor are not there when the chunk is generated again
+    if (mp_decorating != nullptr && mp_decorating != &chunk) {
+        chunk.markIrregenerable();
+    }
+    // remesh what changed once the chunk is on the gpu
+    if (chunk.isMeshed()) {
+        markDirty(x, y, z);
+    }
+}
+
+// fill the blocks y0 <= y < y1 of a world-space column with a type
+// when there is no chunk, do nothing
+void Terrain::fillColumn(int x, int z, int y0, int y1, BlockType t) {
+    Chunk* chunk = m_chunks.find(hash(x & -16, z & -16));
+    if (chunk == nullptr) {
+        return;
+    }
+    fillColumnIn(*chunk, x, z, y0, y1, t);
+}
+
+// fill the blocks y0 <= y < y1 of a world-space column of the chunk holding it
+void Terrain::fillColumnIn(Chunk &chunk, int x, int z, int y0, int y1, BlockType t) {
+    if (y0 >= y1) {
+        return;
+    }
+    chunk.fillColumn(x & 15, z & 15, y0, y1, t);
+    if (mp_decorating != nullptr && mp_decorating != &chunk) {
+        chunk.markIrregenerable();
+    }
+    if (chunk.isMeshed()) {
+        markDirty(x, z, y0, y1);
+    }
+}
+
+// fill a world-space box with a type, min corner inclusive, max corner exclusive,
+// one chunk at a time, the parts without a chunk are skipped
+void Terrain::fillBox(int x0, int y0, int z0, int x1, int y1, int z1, BlockType t) {
+    if (x0 >= x1 || y0 >= y1 || z0 >= z1) {
+        return;
+    }
+    for (int xo = x0 & -16; xo < x1; xo += 16) {
+        for (int zo = z0 & -16; zo < z1; zo += 16) {
+            Chunk* chunk = m_chunks.find(hash(xo, zo));
+            if (chunk == nullptr) {
+                continue;
+            }
+            int xmin = std::max(x0, xo);
+            int zmin = std::max(z0, zo);
+            int xmax = std::min(x1, xo + 16);
+            int zmax = std::min(z1, zo + 16);
+            chunk->fillBox(xmin - xo, y0, zmin - zo, xmax - xo, y1, zmax - zo, t);
+            if (mp_decorating != nullptr && mp_decorating != chunk) {
+                chunk->markIrregenerable();
+            }
+            if (chunk->isMeshed()) {
+                for (int x = xmin; x < xmax; x++) {
+                    for (int z = zmin; z < zmax; z++) {
+                        markDirty(x, z, y0, y1);
+                    }
+                }
+            }
+        }
+    }
+}
+
+// set the blocktype at a world-space position for the player,
+// and record it as an edit of the chunk
+void Terrain::editBlockAt(int x, int y, int z, BlockType t) {
+    setBlockAt(x, y, z, t);
+    int xo = x & -16;
+    int zo = z & -16;
+    Chunk* chunk = m_chunks.find(hash(xo, zo));
+    if (chunk != nullptr) {
+        chunk->recordEdit(x - xo, y, z - zo, t);
+    }
+}
+
+// get the y of the highest collidable block at a world-space column
+// return -1 when there is none or no chunk is there
+int Terrain::getHeightAt(int x, int z) const
+{
+    int xo = x & -16;
+    int zo = z & -16;
+    const Chunk* chunk = m_chunks.find(hash(xo, zo));
+    if (chunk == nullptr) {
+        return -1;
+    }
+    return chunk->heightAt(x - xo, z - zo);
+}
+
+// get the biome at a world-space column, from its chunk's biome map,
+// evaluated from the noise only when no chunk is there
+BiomeType Terrain::getBiomeAt(int x, int z) const
+{
+    int xo = x & -16;
+    int zo = z & -16;
+    const Chunk* chunk = m_chunks.find(hash(xo, zo));
+    if (chunk == nullptr) {
+        return Biome(x, z).getBiome();
+    }
+    return chunk->biomes().typeAt(x - xo, z - zo);
 }
 
 // find if there is a chunk at a world-space position
@@ -49,11 +208,7 @@ bool Terrain::hasChunk(int x, int z, int y) const {
     if (y < 0 || y > 255) {
         return false;
     }
-    moveToOrigin(x, z);
-    if (m_chunks.count(hash(x, z))) {
-        return true;
-    }
-    return false;
+    return m_chunks.contains(hash(x & -16, z & -16));
 }
 
 // get the chunk at a world-space position, if no chunk, return nullptr
@@ -61,32 +216,169 @@ Chunk* Terrain::getChunk(int x, int z, int y) {
     if (y < 0 || y > 255) {
         return nullptr;
     }
-    moveToOrigin(x, z);
-    if (m_chunks.count(hash(x, z))) {
-        return &(m_chunks.find(hash(x, z))->second);
+    return m_chunks.find(hash(x & -16, z & -16));
+}
+
+// generate the basic terrain of a chunk apart from the terrain, safe to run
+// on any thread as it only reads the noise and writes the new chunk
+uPtr<Chunk> Terrain::generateChunk(int x0, int z0, const BiomeMap *map) const {
+    moveToOrigin(x0, z0);
+    uPtr<Chunk> chunk = mkU<Chunk>(m_context, glm::vec4(x0, 0, z0, 1));
+    buildChunk(*chunk, map);
+    return chunk;
+}
+
+// load a saved chunk apart from the terrain, safe to run on any thread,
+// return nullptr when it was never saved
+uPtr<Chunk> Terrain::loadChunk(int x0, int z0, const BiomeMap *map) const {
+    moveToOrigin(x0, z0);
+    uPtr<Chunk> chunk = mkU<Chunk>(m_context, glm::vec4(x0, 0, z0, 1));
+    if (!mp_store->load(x0, z0, *chunk)) {
+        return nullptr;
     }
-    return nullptr;
+    // saved as its edits alone, generate it again, the edits are replayed once decorated
+    if (chunk->awaitsReplay()) {
+        buildChunk(*chunk, map);
+    } else if (map != nullptr) {
+        chunk->m_biomes = *map;
+    } else {
+        chunk->m_biomes.build(x0, z0);
+    }
+    return chunk;
 }
 
-// give a player world-space position, check if it's near boarder
-bool Terrain::checkBooarder(int x, int z, Rect16 &result) {
-    for (int i = 0; i < 81; i++) {
-        int xi = x + (i / 9) * 16 - 64;
-        int zi = z + (i % 9) * 16 - 64;
-        if (abs(xi - x) + abs(zi - z) > 80) {
-            continue;
+// build a group of 16 FBM chunks, the missing chunks of the 64 x 64 area from a base,
+// from the biome maps BiomeMap::buildGroup gave for the area, one job per chunk,
+// return once the jobs are done
+void Terrain::buildFbmGroup(int baseX, int baseZ, const BiomeMap *groupMaps, JobSystem &jobs) {
+    moveToOrigin(baseX, baseZ, 64);
+    // shared with the last job, which may still hold it once the wait returns
+    sPtr<std::promise<void>> built = mkS<std::promise<void>>();
+    std::future<void> finished = built->get_future();
+    JobHandle done = jobs.create([built]() {
+        built->set_value();
+    });
+    std::vector<JobHandle> fills;
+    for (int j = 0; j < 4; j++) {
+        for (int i = 0; i < 4; i++) {
+            int x = baseX + i * 16;
+            int z = baseZ + j * 16;
+            if (m_chunks.contains(hash(x, z))) {
+                continue;
+            }
+            // the chunks are inserted up front, the jobs only write to the blocks of their own
+            Chunk* chunk = m_chunks.insert(hash(x, z), mkU<Chunk>(m_context, glm::vec4(x, 0, z, 1)));
+            const BiomeMap* map = &groupMaps[j * 4 + i];
+            fills.push_back(jobs.create([this, chunk, map]() {
+                buildChunk(*chunk, map);
+            }));
+            jobs.depend(done, fills.back());
         }
-        if (!hasChunk(xi, zi)) {
-            moveToOrigin(xi, zi);
-            m_chunks.emplace(std::make_pair(hash(xi, zi), Chunk(m_context, glm::vec4(xi, 0, zi, 1))));
-            setNeighbor(xi, zi);
-            result = Rect16(xi, zi);
-            buildWeather(xi, zi, true);
-            return true;
+    }
+    for (const JobHandle& fill : fills) {
+        jobs.submit(fill);
+    }
+    jobs.submit(done);
+    finished.wait();
+}
+
+// add a generated or loaded chunk to the terrain and link it to its neighbors,
+// then queue it and the edge strips of its neighbors facing it for meshing
+Chunk* Terrain::insertChunk(uPtr<Chunk> chunk) {
+    int x = (int)chunk->m_originPos.x;
+    int z = (int)chunk->m_originPos.z;
+    m_pending.erase(hash(x, z));
+    m_explored.insert(hash(x & -64, z & -64));
+    Chunk& inserted = *m_chunks.insert(hash(x, z), std::move(chunk));
+    setNeighbor(x, z);
+    buildWeather(x, z, true);
+    inserted.markAllDirty();
+    if (inserted.left != nullptr) {
+        inserted.left->markEdgeDirty(RIGHT);
+    }
+    if (inserted.right != nullptr) {
+        inserted.right->markEdgeDirty(LEFT);
+    }
+    if (inserted.front != nullptr) {
+        inserted.front->markEdgeDirty(BACK);
+    }
+    if (inserted.back != nullptr) {
+        inserted.back->markEdgeDirty(FRONT);
+    }
+    return &inserted;
+}
+
+// save a chunk when it changed, then destroy it and its weather and unlink it from
+// its neighbors, return false while a mesh job still holds the chunk
+bool Terrain::unloadChunk(int x, int z) {
+    moveToOrigin(x, z);
+    Chunk* found = m_chunks.find(hash(x, z));
+    if (found == nullptr) {
+        return true;
+    }
+    Chunk& chunk = *found;
+    if (chunk.isMeshing()) {
+        return false;
+    }
+    if (chunk.isUnsaved()) {
+        mp_store->save(x, z, chunk);
+    }
+    // the neighbors now face empty space, so their facing edge strips are remeshed
+    if (chunk.left != nullptr) {
+        chunk.left->right = nullptr;
+        chunk.left->markEdgeDirty(RIGHT);
+    }
+    if (chunk.right != nullptr) {
+        chunk.right->left = nullptr;
+        chunk.right->markEdgeDirty(LEFT);
+    }
+    if (chunk.front != nullptr) {
+        chunk.front->back = nullptr;
+        chunk.front->markEdgeDirty(BACK);
+    }
+    if (chunk.back != nullptr) {
+        chunk.back->front = nullptr;
+        chunk.back->markEdgeDirty(FRONT);
+    }
+    chunk.destroy();
+    m_chunks.erase(hash(x, z));
+    auto rain = m_rain.find(hash(x, z));
+    if (rain != m_rain.end()) {
+        rain->second.destroy();
+        m_rain.erase(rain);
+    }
+    auto snow = m_snow.find(hash(x, z));
+    if (snow != m_snow.end()) {
+        snow->second.destroy();
+        m_snow.erase(snow);
+    }
+    auto lightening = m_lightening.find(hash(x, z));
+    if (lightening != m_lightening.end()) {
+        lightening->second.destroy();
+        m_lightening.erase(lightening);
+    }
+    return true;
+}
+
+// queue every loaded chunk that changed for saving
+void Terrain::saveChunks() {
+    for (Chunk& chunk : m_chunks) {
+        if (chunk.isUnsaved()) {
+            glm::vec4 origin = chunk.m_originPos;
+            mp_store->save((int)origin.x, (int)origin.z, chunk);
+            chunk.markSaved();
         }
     }
-    return false;
+}
 
+// number of saved chunks waiting to be written
+int Terrain::savesPending() const {
+    return mp_store->pendingCount();
+}
+
+// write the saved chunks to the region files, safe on any thread
+void Terrain::flushSaves() {
+    mp_store->flush();
 }
 
 // ray cast from camera to terrain, removing or adding block by click
@@ -133,16 +425,14 @@ void Terrain::playerClick(glm::vec3 ori, glm::vec3 dir, bool add) {
             if (add && length < 8.f) {
                 Chunk* chunk = getChunk(backBlock.x, backBlock.z, backBlock.y);
                 if (chunk != nullptr) {
-                    setBlockAt(backBlock.x, backBlock.y, backBlock.z, LAVA);
-                    updateWeather(backBlock.x, backBlock.y, backBlock.z);
-                    chunk->combinedCreate();
+                    editBlockAt(backBlock.x, backBlock.y, backBlock.z, LAVA);
+                    updateWeather(backBlock.x, backBlock.z);
                 }
             } else if (!add) {
                 Chunk* chunk = getChunk(block.x, block.z, block.y);
                 if (chunk != nullptr) {
-                    setBlockAt(block.x, block.y, block.z, EMPTY);
-                    updateWeather(backBlock.x, backBlock.y - 1, backBlock.z);
-                    chunk->combinedCreate();
+                    editBlockAt(block.x, block.y, block.z, EMPTY);
+                    updateWeather(block.x, block.z);
                 }
             }
             break;
@@ -150,11 +440,85 @@ void Terrain::playerClick(glm::vec3 ori, glm::vec3 dir, bool add) {
     }
 }
 
+// mark the sections and edge strips that show an edited block for remeshing,
+// including the edge strip of a neighbor when the block sits on its border
+void Terrain::markDirty(int x, int y, int z) {
+    markDirty(x, z, y, y + 1);
+}
+
+// mark the sections and edge strips that show the blocks y0 <= y < y1 of a column
+// for remeshing, including the edge strip of a neighbor when the column sits on its border
+void Terrain::markDirty(int x, int z, int y0, int y1) {
+    y0 = std::max(y0, 0);
+    y1 = std::min(y1, 256);
+    if (y0 >= y1) {
+        return;
+    }
+    // faces between sections and chunks depend on both sides,
+    // so the sections just below and above the span are marked too
+    int last = std::min(y1, 255) / 16;
+    for (int section = std::max(y0 - 1, 0) / 16; section <= last; section++) {
+        markSectionDirty(x, z, section);
+    }
+    int xo = x;
+    int zo = z;
+    moveToOrigin(xo, zo);
+    if (x - xo == 0) {
+        markEdgeDirty(x, z, LEFT);
+        markEdgeDirty(x - 1, z, RIGHT);
+    } else if (x - xo == 15) {
+        markEdgeDirty(x, z, RIGHT);
+        markEdgeDirty(x + 1, z, LEFT);
+    }
+    if (z - zo == 0) {
+        markEdgeDirty(x, z, BACK);
+        markEdgeDirty(x, z - 1, FRONT);
+    } else if (z - zo == 15) {
+        markEdgeDirty(x, z, FRONT);
+        markEdgeDirty(x, z + 1, BACK);
+    }
+}
+
+// mark a section of the chunk at a world-space column for remeshing
+void Terrain::markSectionDirty(int x, int z, int section) {
+    moveToOrigin(x, z);
+    Chunk* chunk = m_chunks.find(hash(x, z));
+    if (chunk == nullptr) {
+        return;
+    }
+    chunk->markSectionDirty(section);
+}
+
+// mark an edge strip of the chunk at a world-space column for remeshing
+void Terrain::markEdgeDirty(int x, int z, FaceType edge) {
+    moveToOrigin(x, z);
+    Chunk* chunk = m_chunks.find(hash(x, z));
+    if (chunk == nullptr) {
+        return;
+    }
+    chunk->markEdgeDirty(edge);
+}
+
+// return the chunks with sections or edge strips to remesh
+std::vector<Chunk*> Terrain::dirtyChunks() {
+    std::vector<Chunk*> chunks;
+    for (Chunk& chunk : m_chunks) {
+        if (chunk.isDirty()) {
+            chunks.push_back(&chunk);
+        }
+    }
+    return chunks;
+}
+
 // check if a given area is explored
 bool Terrain::explored(const Rect64 &area) const {
+    if (m_explored.count(hash(area.xmin, area.zmin))) {
+        return true;
+    }
+    // areas of the saved world not loaded yet
     for (int i = 0; i < 64; i += 16) {
         for (int j = 0; j < 64; j += 16) {
-            if (hasChunk(area.xmin + i, area.zmin + j)) {
+            if (mp_store->contains(area.xmin + i, area.zmin + j)) {
                 return true;
             }
         }
@@ -189,12 +553,13 @@ void Terrain::buildWeather(int x, int z, bool shouldCreate) {
             m_snow.find(hash(x, z))->second.create();
         }
     }
-    if (z >= 128) {
+    // the lightning strikes the chunk at (-32, 256), only while that chunk is loaded
+    if (z >= 128 && hasChunk(-32, 256)) {
         x = -32;
         z = 256;
         Lightening lightening(m_context, glm::vec4(x, 0, z, 1));
-        m_lightening.emplace(std::make_pair(hash(x, z), lightening));
-        if (shouldCreate) {
+        bool inserted = m_lightening.emplace(std::make_pair(hash(x, z), lightening)).second;
+        if (shouldCreate && inserted) {
             m_lightening.find(hash(x, z))->second.create();
         }
     }
@@ -212,12 +577,36 @@ void Terrain::updateHeight(int x, int z, int h) {
     }
 }
 
-void Terrain::updateWeather(int x, int y, int z) {
+// get the height rain bounces off at a world-space column
+// rain does not bounce off water, so return -1 there
+int Terrain::rainHeightAt(int x, int z) const {
+    int y = getHeightAt(x, z);
+    if (y >= 0 && getBlockAt(x, y + 1, z) == WATER) {
+        y = -1;
+    }
+    return y;
+}
+
+// update the rain heights of every column of a chunk
+void Terrain::updateRainHeights(int x, int z) {
+    moveToOrigin(x, z);
+    auto it = m_rain.find(hash(x, z));
+    if (it == m_rain.end()) {
+        return;
+    }
+    for (int i = 0; i < 16; i++) {
+        for (int j = 0; j < 16; j++) {
+            it->second.setHeight(i, j, rainHeightAt(x + i, z + j));
+        }
+    }
+}
+
+void Terrain::updateWeather(int x, int z) {
     int xpos = x;
     int zpos = z;
     moveToOrigin(x, z);
     if (canRain(x + 8, z + 8)) {
-        updateHeight(xpos, zpos, y);
+        updateHeight(xpos, zpos, rainHeightAt(xpos, zpos));
         m_rain.find(hash(x, z))->second.destroy();
         m_rain.find(hash(x, z))->second.create();
     }
@@ -228,8 +617,7 @@ void Terrain::createCloud(int px, int pz) {
     if (pz % 64 != 0 || px % 64 != 0) {
         return;
     }
-    float seed = noise::rand2D((float)(px % 1024), (float)(pz % 1024),
-                               123.4f, 345.6f, 456.7f) * 111.f;
+    float seed = noise::columnRand(px, pz, 123.4f, 345.6f, 456.7f) * 111.f;
     //float rand = noise::rand1D(seed);
     //if (rand < 0.6f) {
         //return;
@@ -248,8 +636,7 @@ void Terrain::createCloud(int px, int pz) {
 }
 
 bool Terrain::canRain(int x, int z) const {
-    Biome biome(x, z);
-    BiomeType biomeType = biome.getBiome();
+    BiomeType biomeType = getBiomeAt(x, z);
     if (biomeType == JUNGLE) {
         return true;
     } else {
@@ -258,8 +645,7 @@ bool Terrain::canRain(int x, int z) const {
 }
 
 bool Terrain::canSnow(int x, int z) const {
-    Biome biome(x, z);
-    BiomeType biomeType = biome.getBiome();
+    BiomeType biomeType = getBiomeAt(x, z);
     if (biomeType == FROZEN) {
         return true;
     } else {
@@ -297,8 +683,8 @@ void Terrain::moveToOrigin(int &x, int &z, int module) const {
 
 // openGL create all chunks
 void Terrain::create() {
-    for (auto it = m_chunks.begin(); it != m_chunks.end(); it++) {
-        (it->second).create();
+    for (Chunk& chunk : m_chunks) {
+        chunk.create();
     }
     for (auto it = m_rain.begin(); it != m_rain.end(); it++) {
         (it->second).create();
@@ -313,8 +699,8 @@ void Terrain::create() {
 
 // openGL destroy all chunks
 void Terrain::destroy() {
-    for (auto it = m_chunks.begin(); it != m_chunks.end(); it++) {
-        (it->second).destroy();
+    for (Chunk& chunk : m_chunks) {
+        chunk.destroy();
     }
     for (auto it = m_rain.begin(); it != m_rain.end(); it++) {
         (it->second).destroy();
@@ -329,31 +715,28 @@ void Terrain::destroy() {
 
 // set up neigborhood for a chunk at given origin
 void Terrain::setNeighbor(int x, int z) {
-    if (!hasChunk(x, z)) {
+    Chunk* chunk = getChunk(x, z);
+    if (chunk == nullptr) {
         return;
     }
-    if (hasChunk(x - 16, z)) {
-        m_chunks.find(hash(x, z))->second.left =
-                &m_chunks.find(hash(x - 16, z))->second;
-        m_chunks.find(hash(x - 16, z))->second.right =
-                &m_chunks.find(hash(x, z))->second;
-    }
-    if (hasChunk(x + 16, z)) {
-        m_chunks.find(hash(x, z))->second.right =
-                &m_chunks.find(hash(x + 16, z))->second;
-        m_chunks.find(hash(x + 16, z))->second.left =
-                &m_chunks.find(hash(x, z))->second;
-    }
-    if (hasChunk(x, z - 16)) {
-        m_chunks.find(hash(x, z))->second.back =
-                &m_chunks.find(hash(x, z - 16))->second;
-        m_chunks.find(hash(x, z - 16))->second.front =
-                &m_chunks.find(hash(x, z))->second;
-    }
-    if (hasChunk(x, z + 16)) {
-        m_chunks.find(hash(x, z))->second.front =
-                &m_chunks.find(hash(x, z + 16))->second;
-        m_chunks.find(hash(x, z + 16))->second.back =
-                &m_chunks.find(hash(x, z))->second;
+    Chunk* left = getChunk(x - 16, z);
+    if (left != nullptr) {
+        chunk->left = left;
+        left->right = chunk;
+    }
+    Chunk* right = getChunk(x + 16, z);
+    if (right != nullptr) {
+        chunk->right = right;
+        right->left = chunk;
+    }
+    Chunk* back = getChunk(x, z - 16);
+    if (back != nullptr) {
+        chunk->back = back;
+        back->front = chunk;
+    }
+    Chunk* front = getChunk(x, z + 16);
+    if (front != nullptr) {
+        chunk->front = front;
+        front->back = chunk;
     }
 }
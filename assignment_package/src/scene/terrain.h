@@ -1,28 +1,53 @@
 #pragma once
 #include <QList>
+#include <set>
 #include "biome.h"
 #include "chunk.h"
 #include "rectangle.h"
 #include "raindrop.h"
 #include "lightening.h"
 #include "snow.h"
+#include "regionstore.h"
+#include "chunkmap.h"
+
+class JobSystem;
 
 class Terrain
 {
     friend class MyGL;
+    friend class ChunkScheduler;
+    friend class BlockCursor;
 private:
     // hashmap of all chucks
-    std::map<int64_t, Chunk> m_chunks;
+    ChunkMap m_chunks;
+    // chunks handed out by the chunk scheduler that are still being generated
+    std::set<int64_t> m_pending;
+    // 64x64 areas that ever held a chunk, by the hash of their origin,
+    // kept after their chunks are unloaded so rivers do not cut into them
+    std::set<int64_t> m_explored;
     std::map<int64_t, RainDrop> m_rain;
     std::map<int64_t, Snow> m_snow;
     std::map<int64_t, Lightening> m_lightening;
 
     // pass openGL context to chunks
     OpenGLContext* m_context;
+    // the saved world, chunks are saved when unloaded and loaded instead of generated
+    uPtr<RegionStore> mp_store;
+    // initial chunks generated rather than loaded, which still need rivers and assets
+    std::vector<Rect16> m_undecorated;
+    // the chunk placeAssets is decorating, writes to other chunks make them irregenerable
+    Chunk* mp_decorating;
 
 public:
     // construct and initialize
     Terrain(OpenGLContext* m_context);
+    // load the saved chunks of the first 64 x 64 area, then generate the others as a group
+    // on the workers of a job system, and wait for them, both from one pass of biome maps
+    void createFirstArea(JobSystem &jobs);
+    // build a group of 16 FBM chunks, the missing chunks of the 64 x 64 area from a base,
+    // from the biome maps BiomeMap::buildGroup gave for the area, one job per chunk,
+    // return once the jobs are done
+    void buildFbmGroup(int baseX, int baseZ, const BiomeMap *groupMaps, JobSystem &jobs);
 
     // get the blocktype at a world-space position
     // return empty when no block is there
@@ -30,19 +55,56 @@ public:
     // set the blocktype at a world-space position
     // when there is no chunk, do nothing
     void setBlockAt(int x, int y, int z, BlockType t);
+    // set the blocktype at a world-space position for the player,
+    // and record it as an edit of the chunk
+    void editBlockAt(int x, int y, int z, BlockType t);
+    // fill the blocks y0 <= y < y1 of a world-space column with a type
+    // when there is no chunk, do nothing
+    void fillColumn(int x, int z, int y0, int y1, BlockType t);
+    // fill a world-space box with a type, min corner inclusive, max corner exclusive,
+    // the parts without a chunk are skipped
+    void fillBox(int x0, int y0, int z0, int x1, int y1, int z1, BlockType t);
+    // get the y of the highest collidable block at a world-space column
+    // return -1 when there is none or no chunk is there
+    int getHeightAt(int x, int z) const;
+    // get the biome at a world-space column, from its chunk's biome map,
+    // evaluated from the noise only when no chunk is there
+    BiomeType getBiomeAt(int x, int z) const;
 
     // find if there is a chunk at a world-space position
     bool hasChunk(int x, int z, int y = 128) const;
     // get the chunk at a world-space position, if no chunk, return nullptr
     Chunk* getChunk(int x, int z, int y = 128);
 
-    // give a player world-space position, check if it's near boarder
-    bool checkBooarder(int x, int z, Rect16 &result);
-    // build basic terrain of a chunk
-    void buildChunk(int x0, int z0);
+    // generate the basic terrain of a chunk apart from the terrain, safe on any thread,
+    // from the chunk's biome map when given, see BiomeMap::buildGroup
+    uPtr<Chunk> generateChunk(int x0, int z0, const BiomeMap *map = nullptr) const;
+    // load a saved chunk apart from the terrain, safe on any thread,
+    // return nullptr when it was never saved
+    uPtr<Chunk> loadChunk(int x0, int z0, const BiomeMap *map = nullptr) const;
+    // build basic terrain of a chunk, writing only to that chunk
+    void buildChunk(Chunk &chunk, const BiomeMap *map = nullptr) const;
+    // add a generated or loaded chunk to the terrain, link it to its neighbors and queue its mesh
+    Chunk* insertChunk(uPtr<Chunk> chunk);
+    // save a chunk when it changed, then destroy it and its weather and unlink it from
+    // its neighbors, return false while a mesh job still holds the chunk
+    bool unloadChunk(int x, int z);
+    // queue every loaded chunk that changed for saving
+    void saveChunks();
+    // number of saved chunks waiting to be written
+    int savesPending() const;
+    // write the saved chunks to the region files, safe on any thread
+    void flushSaves();
 
     // ray cast from camera to terrain, removing or adding block by click
     void playerClick(glm::vec3 ori, glm::vec3 dir, bool add);
+    // mark the sections and edge strips that show an edited block for remeshing,
+    // including the edge strip of a neighbor when the block sits on its border
+    void markDirty(int x, int y, int z);
+    // the same for the blocks y0 <= y < y1 of a column
+    void markDirty(int x, int z, int y0, int y1);
+    // return the chunks with sections or edge strips to remesh
+    std::vector<Chunk*> dirtyChunks();
 
     // check if a given area is explored
     bool explored(const Rect64 &area) const;
@@ -57,8 +119,10 @@ public:
     void buildWeather(int x, int z, bool shouldCreate = false);
     // update the height
     void updateHeight(int x, int z, int h);
-    // update weather
-    void updateWeather(int x, int y, int z);
+    // update weather to the current height of a column
+    void updateWeather(int x, int z);
+    // update the rain heights of every column of a chunk
+    void updateRainHeights(int x, int z);
     // create cloud
     void createCloud(int x, int z);
     // if this pos can rain
@@ -71,6 +135,12 @@ private:
     int64_t hash (int x, int z) const;
     // move a point to the origin of the chunk it lives in
     void moveToOrigin(int &x, int &z, int module = 16) const;
+    // set the blocktype at a world-space position of the chunk holding it
+    void setBlockIn(Chunk &chunk, int x, int y, int z, BlockType t);
+    // fill the blocks y0 <= y < y1 of a world-space column of the chunk holding it
+    void fillColumnIn(Chunk &chunk, int x, int z, int y0, int y1, BlockType t);
+    // get the height rain bounces off at a world-space column
+    int rainHeightAt(int x, int z) const;
 
     // openGL create all chunks
     void create();
@@ -79,9 +149,8 @@ private:
 
     // set up neigborhood for a chunk at given origin
     void setNeighbor(int x, int z);
-
-    // build pending chunks with multi-thread
-    void buildChunkThread();
-    // build a group of 16 FBM chunks
-    void buildFbmGroup(int baseX, int baseZ);
+    // mark a section of the chunk at a world-space column for remeshing
+    void markSectionDirty(int x, int z, int section);
+    // mark an edge strip of the chunk at a world-space column for remeshing
+    void markEdgeDirty(int x, int z, FaceType edge);
 };
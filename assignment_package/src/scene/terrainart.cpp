@@ -1,157 +1,147 @@
 #include "terrain.h"
+#include "blockcursor.h"
 
-// build basic terrain of a chunk
-void Terrain::buildChunk(int x0, int z0) {
-    Biome::InitializeParams();
-    moveToOrigin(x0, z0);
+// the block under the surface of a biome, EMPTY when there is none
+static BlockType soilType(BiomeType biomeType) {
+    switch (biomeType) {
+    case PLAIN:
+    case TUNDRA:
+    case FROZEN:
+        return DIRT;
+    case DARK:
+        return EVIL;
+    case DESERT:
+        return SAND;
+    case JUNGLE:
+        return LEAFMOLD;
+    case MOUNTAIN:
+        return STONE;
+    default:
+        return EMPTY;
+    }
+}
+
+// the top block of a biome, EMPTY when there is none
+static BlockType surfaceType(BiomeType biomeType) {
+    switch (biomeType) {
+    case PLAIN:
+        return GRASS;
+    case DARK:
+        return EVIL;
+    case DESERT:
+        return SAND;
+    case FROZEN:
+        return SNOW;
+    case JUNGLE:
+        return LEAFMOLD;
+    case TUNDRA:
+        return FROZEDIRT;
+    case MOUNTAIN:
+        return STONE;
+    default:
+        return EMPTY;
+    }
+}
+
+// what fills a biome's lakes and rivers up to the sea level
+static BlockType waterType(BiomeType biomeType) {
+    switch (biomeType) {
+    case FROZEN:
+    case TUNDRA:
+    case DARK:
+    case MOUNTAIN:
+        return ICE;
+    default:
+        return WATER;
+    }
+}
+
+// build basic terrain of a chunk, writing only to that chunk, from its biome map
+// when given, every column is laid out as spans of one type and written at once
+void Terrain::buildChunk(Chunk &chunk, const BiomeMap *map) const {
+    if (map != nullptr) {
+        chunk.m_biomes = *map;
+    } else {
+        chunk.m_biomes.build((int)chunk.m_originPos.x, (int)chunk.m_originPos.z);
+    }
+    BlockType column[256];
+    const BiomeMap& biomes = chunk.m_biomes;
     for (int x = 0; x < 16; x++) {
         for (int z = 0; z < 16; z++) {
-            int xi = x + x0;
-            int zi = z + z0;
-            int top = 0;
-            Biome biome(xi, zi);
-            BiomeType biomeType = biome.getBiome(top);
+            int top = biomes.heightAt(x, z);
+            BiomeType biomeType = biomes.typeAt(x, z);
             // lake feature
             if (top <= 128) { top -= 1; }
             // sand dune feature
             if (biomeType == DESERT && top > 134) {
                 top = 134 + (int)((float)(top - 134) * 0.3f);
             }
-            int bounce = top;
-            // place blocks
-            for (int y = 0; y < 256; y++) {
-                if (y <= 128 && y < top) {
-                    setBlockAt(xi, y, zi, STONE);
-                } else if (y <= 128 && y == top) {
-                    setBlockAt(xi, y, zi, BEDROCK);
-                } else if (y <= 128) {
-                    switch (biomeType) {
-                    case FROZEN:
-                    case TUNDRA:
-                    case DARK:
-                    case MOUNTAIN:
-                        setBlockAt(xi, y, zi, ICE);
-                        break;
-                    default:
-                        setBlockAt(xi, y, zi, WATER);
-                        bounce = -1;
-                        break;
-                    }
-                } else if (y < top) {
-                    switch (biomeType) {
-                    case PLAIN:
-                    case TUNDRA:
-                    case FROZEN:
-                        setBlockAt(xi, y, zi, DIRT);
-                        break;
-                    case DARK:
-                        setBlockAt(xi, y, zi, EVIL);
-                        break;
-                    case DESERT:
-                        setBlockAt(xi, y, zi, SAND);
-                        break;
-                    case JUNGLE:
-                        setBlockAt(xi, y, zi, LEAFMOLD);
-                        break;
-                    case MOUNTAIN:
-                        setBlockAt(xi, y, zi, STONE);
-                        break;
-                    default:
-                        break;
-                    }
-                } else if (y == top) {
-                    switch (biomeType) {
-                    case PLAIN:
-                        setBlockAt(xi, y, zi, GRASS);
-                        break;
-                    case DARK:
-                        setBlockAt(xi, y, zi, EVIL);
-                        break;
-                    case DESERT:
-                        setBlockAt(xi, y, zi, SAND);
-                        break;
-                    case FROZEN:
-                        setBlockAt(xi, y, zi, SNOW);
-                        break;
-                    case JUNGLE:
-                        setBlockAt(xi, y, zi, LEAFMOLD);
-                        break;
-                    case TUNDRA:
-                        setBlockAt(xi, y, zi, FROZEDIRT);
-                        break;
-                    case MOUNTAIN:
-                        setBlockAt(xi, y, zi, STONE);
-                        break;
-                    default:
-                        break;
-                    }
-                } else {
-                    setBlockAt(xi, y, zi, EMPTY);
+            // place blocks, stone and water up to the sea level, soil and surface above
+            int stone = std::max(0, std::min(top, 129));
+            std::fill(column, column + stone, STONE);
+            std::fill(column + stone, column + 129, waterType(biomeType));
+            std::fill(column + 129, column + 256, EMPTY);
+            if (top >= 0 && top <= 128) {
+                column[top] = BEDROCK;
+            } else if (top > 128) {
+                std::fill(column + 129, column + std::min(top, 256), soilType(biomeType));
+                if (top < 256) {
+                    column[top] = surfaceType(biomeType);
                 }
             }
-            updateHeight(xi, zi, bounce);
+            chunk.setColumn(x, z, column);
         }
     }
-    createCloud(x0, z0);
 }
 
 // use water to erode a location to a given height
 void Terrain::waterErode(int x, int z, int restY) {
-    Biome biome(x, z);
-    BiomeType biomeType = biome.getBiome();
-    bool hasWater = false;
-    for (int y = 255; y > restY; y--) {
-        if (y > 128) {
-            setBlockAt(x, y, z, EMPTY);
-        } else {
-            hasWater = true;
-            switch (biomeType) {
-            case FROZEN:
-            case TUNDRA:
-            case DARK:
-            case MOUNTAIN:
-                setBlockAt(x, y, z, ICE);
-                break;
-            default:
-                setBlockAt(x, y, z, WATER);
-                break;
-            }
-        }
+    BiomeType biomeType = getBiomeAt(x, z);
+    // rivers follow what this session explored, generating the chunk again
+    // would not bring them back, so only a full copy can restore it
+    Chunk* chunk = getChunk(x, z);
+    if (chunk != nullptr) {
+        chunk->markIrregenerable();
     }
+    BlockCursor cursor(this, x, z);
+    // clear the column above the sea level and flood it below
+    cursor.fillColumn(x, z, std::max(restY + 1, 129), 256, EMPTY);
+    cursor.fillColumn(x, z, restY + 1, 129, waterType(biomeType));
+    bool hasWater = restY < 128;
     if (hasWater) {
         updateHeight(x, z, -1);
     }
-    BlockType restType = getBlockAt(x, restY, z);
+    BlockType restType = cursor.getBlockAt(x, restY, z);
     if (restType != EMPTY && restType != WATER &&
         restType != LAVA && restType != ICE) {
         if (restY >= 128) {
             switch (biomeType) {
             case PLAIN:
-                setBlockAt(x, restY, z, GRASS);
+                cursor.setBlockAt(x, restY, z, GRASS);
                 break;
             case DARK:
-                setBlockAt(x, restY, z, EVIL);
+                cursor.setBlockAt(x, restY, z, EVIL);
                 break;
             case DESERT:
-                setBlockAt(x, restY, z, SAND);
+                cursor.setBlockAt(x, restY, z, SAND);
                 break;
             case FROZEN:
-                setBlockAt(x, restY, z, SNOW);
+                cursor.setBlockAt(x, restY, z, SNOW);
                 break;
             case JUNGLE:
-                setBlockAt(x, restY, z, LEAFMOLD);
+                cursor.setBlockAt(x, restY, z, LEAFMOLD);
                 break;
             case TUNDRA:
-                setBlockAt(x, restY, z, FROZEDIRT);
+                cursor.setBlockAt(x, restY, z, FROZEDIRT);
                 break;
             case MOUNTAIN:
-                setBlockAt(x, restY, z, STONE);
+                cursor.setBlockAt(x, restY, z, STONE);
                 break;
             default:
                 break;
             }
         } else {
-            setBlockAt(x, restY, z, BEDROCK);
+            cursor.setBlockAt(x, restY, z, BEDROCK);
         }
         updateHeight(x, z, restY);
     }
@@ -177,23 +167,19 @@ void Terrain::placeAssets(const Rect16 scope) {
     rubyParams.scaleX = 0.1f;
     rubyParams.scaleZ = 0.1f;
     rubyParams.seed1 = 579.1;
+    mp_decorating = getChunk(scope.xmin, scope.zmin);
     for (int x = scope.xmin; x <= scope.xmax; x++) {
         for (int z = scope.zmin; z <= scope.zmax; z++) {
             // find top height
-            int top = 255;
-            for (int y = 255; y >= 100; y--) {
-                if (Chunk::isCollidable(getBlockAt(x, y, z))) {
-                    top = y;
-                    break;
-                }
+            int top = getHeightAt(x, z);
+            if (top < 100) {
+                top = 255;
             }
             // create random value
-            float seed = noise::rand2D((float)(x % 1024), (float)(z % 1024),
-                                       123.4f, 345.6f, 456.7f) * 111.f;
+            float seed = noise::columnRand(x, z, 123.4f, 345.6f, 456.7f) * 111.f;
             float rand = noise::rand1D(seed);
-            // compute biome type
-            Biome biome(x, z);
-            BiomeType biomeType = biome.getBiome();
+            // look up biome type
+            BiomeType biomeType = getBiomeAt(x, z);
             // place different assests
             if (biomeType == PLAIN) {
                 // grass and flower
@@ -211,9 +197,7 @@ void Terrain::placeAssets(const Rect16 scope) {
                 if (top > 130) {
                     if (rand > (float)(165 - top) / 30.f && rand > 0.3f) {
                         int end = top - (int)((float)(top - 135) * rand);
-                        for (int y = top; y >= end; y--) {
-                            setBlockAt(x, y, z, LAVA);
-                        }
+                        fillColumn(x, z, end, top + 1, LAVA);
                     }
                 }
             } else if (biomeType == DESERT) {
@@ -222,13 +206,8 @@ void Terrain::placeAssets(const Rect16 scope) {
                 if (top > bottom) {
                     int orange = top + 1;
                     int red = top + 3 + (int)((float)(top - bottom) * 0.3f);
-                    for (int y = top + 1; y <= red; y++) {
-                        if (y <= orange) {
-                            setBlockAt(x, y, z, ORANGEROCK);
-                        } else {
-                            setBlockAt(x, y, z, REDROCK);
-                        }
-                    }
+                    fillColumn(x, z, top + 1, orange + 1, ORANGEROCK);
+                    fillColumn(x, z, orange + 1, red + 1, REDROCK);
                 }
             } else if (biomeType == FROZEN) {
                 // glacier
@@ -236,9 +215,7 @@ void Terrain::placeAssets(const Rect16 scope) {
                     if (noise::sealedFbm2D(x, z, glacierParams) /
                         glacierParams.scaleY > 0.25f * (float)(top - 130) / 10.f) {
                         int end = top + 1 + (int)((float)(140 - top) * 0.15f);
-                        for (int y = end; y > top; y--) {
-                            setBlockAt(x, y, z, ICE);
-                        }
+                        fillColumn(x, z, top + 1, end + 1, ICE);
                     }
                 }
             } else if (biomeType == JUNGLE) {
@@ -250,34 +227,17 @@ void Terrain::placeAssets(const Rect16 scope) {
                     int height = 2 + (int)(5 * noise::rand1D(seed + 12.3f));
                     BlockType leaf = noise::rand1D(seed + 23.4f) > 0.3 ?
                                      BlockType::LEAF : BlockType::LEAFMOLD;
-                    for (int y = top + 1; y < top + height; y++) {
-                        setBlockAt(x, y, z, WOOD);
-                    }
+                    fillColumn(x, z, top + 1, top + height, WOOD);
                     int y  = top + height;
-                    for (int xi = x - 1; xi <= x + 1; xi++) {
-                        for (int zi = z - 1; zi <= z + 1; zi++) {
-                            setBlockAt(xi, y, zi, leaf);
-                        }
-                    }
+                    fillBox(x - 1, y, z - 1, x + 2, y + 1, z + 2, leaf);
                     y++;
-                    for (int xi = x - 2; xi <= x + 2; xi++) {
-                        for (int zi = z - 2; zi <= z + 2; zi++) {
-                            setBlockAt(xi, y, zi, leaf);
-                        }
-                    }
+                    fillBox(x - 2, y, z - 2, x + 3, y + 1, z + 3, leaf);
                     y++;
-                    for (int xi = x - 1; xi <= x + 1; xi++) {
-                        for (int zi = z - 1; zi <= z + 1; zi++) {
-                            setBlockAt(xi, y, zi, leaf);
-                        }
-                    }
+                    fillBox(x - 1, y, z - 1, x + 2, y + 1, z + 2, leaf);
                     y++;
                     int x0 = noise::rand1D(seed + 34.5f) > 0.5f ? x - 1 : x;
                     int z0 = noise::rand1D(seed + 45.6f) > 0.5f ? z - 1 : z;
-                    setBlockAt(x0, y, z0, leaf);
-                    setBlockAt(x0 + 1, y, z0, leaf);
-                    setBlockAt(x0, y, z0 + 1, leaf);
-                    setBlockAt(x0 + 1, y, z0 + 1, leaf);
+                    fillBox(x0, y, z0, x0 + 2, y + 1, z0 + 2, leaf);
                 }
             } else if (biomeType == TUNDRA) {
                 // hardy plant
@@ -298,28 +258,23 @@ void Terrain::placeAssets(const Rect16 scope) {
                         rubyParams.scaleY > 0.2f) {
                         int low = bottom + 13 + (int)((float)(top - bottom) * 0.05f);
                         int high = bottom + 14 + (int)((float)(top - bottom) * 0.1f);
-                        for (int y = low; y <= high && y <= top; y++) {
-                            setBlockAt(x, y, z, RUBY);
-                        }
+                        fillColumn(x, z, low, std::min(high, top) + 1, RUBY);
                     }
                     if (noise::sealedFbm2D(x, z, goldParams) /
                         goldParams.scaleY > 0.15f) {
                         int low = bottom + 8 + (int)((float)(top - bottom) * 0.05f);
                         int high = bottom + 9 + (int)((float)(top - bottom) * 0.1f);
-                        for (int y = low; y <= high && y <= top; y++) {
-                            setBlockAt(x, y, z, GOLD);
-                        }
+                        fillColumn(x, z, low, std::min(high, top) + 1, GOLD);
                     }
                     if (noise::sealedFbm2D(x, z, coalParams) /
                         coalParams.scaleY > 0.08f) {
                         int low = bottom + 2 + (int)((float)(top - bottom) * 0.05f);
                         int high = bottom + 5 + (int)((float)(top - bottom) * 0.1f);
-                        for (int y = low; y <= high && y <= top; y++) {
-                            setBlockAt(x, y, z, COAL);
-                        }
+                        fillColumn(x, z, low, std::min(high, top) + 1, COAL);
                     }
                 }
             }
         }
     }
+    mp_decorating = nullptr;
 }
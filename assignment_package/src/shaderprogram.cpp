@@ -8,10 +8,11 @@
 ShaderProgram::ShaderProgram(OpenGLContext *context)
     : vertShader(), fragShader(), prog(),
       attrPos(-1), attrNor(-1), attrCol(-1),
-      attrUV(-1), attrCosine(-1), attrAnimated(-1),
+      attrUV(-1), attrCosine(-1), attrAnimated(-1), attrPacked(-1),
       unifModel(-1), unifModelInvTr(-1), unifViewProj(-1),
       unifSampler2D(-1), unifNormalMap(-1), unifTime(-1), unifBlendType(-1),
-      unifEnvironm(-1), unifDimensions(-1), unifEye(-1),
+      unifEnvironm(-1), unifPacked(-1), unifChunkOrigin(-1),
+      unifDimensions(-1), unifEye(-1),
       context(context)
 {}
 
@@ -69,6 +70,7 @@ void ShaderProgram::create(const char *vertfile, const char *fragfile)
     attrUV = context->glGetAttribLocation(prog, "vs_UV");
     attrCosine = context->glGetAttribLocation(prog, "vs_Cosine");
     attrAnimated = context->glGetAttribLocation(prog, "vs_Animated");
+    attrPacked = context->glGetAttribLocation(prog, "vs_Packed");
 
     unifModel      = context->glGetUniformLocation(prog, "u_Model");
     unifModelInvTr = context->glGetUniformLocation(prog, "u_ModelInvTr");
@@ -78,6 +80,8 @@ void ShaderProgram::create(const char *vertfile, const char *fragfile)
     unifTime       = context->glGetUniformLocation(prog, "u_Time");
     unifEnvironm   = context->glGetUniformLocation(prog, "u_Envir");
     unifBlendType  = context->glGetUniformLocation(prog, "u_BlendType");
+    unifPacked     = context->glGetUniformLocation(prog, "u_Packed");
+    unifChunkOrigin = context->glGetUniformLocation(prog, "u_ChunkOrigin");
     // Sky demo
     unifDimensions = context->glGetUniformLocation(prog, "u_Dimensions");
     unifEye = context->glGetUniformLocation(prog, "u_Eye");
@@ -211,105 +215,95 @@ void ShaderProgram::draw(Drawable &d, int bufferIdx, int)
         context->glUniform1i(unifNormalMap, 1);
     }
 
+    // Chunks store packed vertices relative to their origin,
+    // the vertex shader decodes them
+    if (unifPacked != -1) {
+        context->glUniform1i(unifPacked, d.isPacked() ? 1 : 0);
+    }
+    if (unifChunkOrigin != -1 && d.isPacked()) {
+        glm::vec4 origin = d.packedOrigin();
+        context->glUniform3f(unifChunkOrigin, origin.x, origin.y, origin.z);
+    }
+
     // Draw Opaque
     if (bufferIdx == 0) {
         d.bindVer0();
-
-        if (attrPos != -1) {
-            context->glEnableVertexAttribArray(attrPos);
-            context->glVertexAttribPointer(attrPos, 4, GL_FLOAT, false,
-                                           16 * sizeof(float), (void*)0);
-        }
-
-        if (attrNor != -1) {
-            context->glEnableVertexAttribArray(attrNor);
-            context->glVertexAttribPointer(attrNor, 4, GL_FLOAT, false,
-                                           16 * sizeof(float), (void*)(4 * sizeof(float)));
-        }
-
-        if (attrCol != -1) {
-            context->glEnableVertexAttribArray(attrCol);
-            context->glVertexAttribPointer(attrCol, 4, GL_FLOAT, false,
-                                           16 * sizeof(float), (void*)(8 * sizeof(float)));
-        }
-
-        if (attrUV != -1) {
-            context->glEnableVertexAttribArray(attrUV);
-            context->glVertexAttribPointer(attrUV, 2, GL_FLOAT, false,
-                                           16 * sizeof(float), (void*)(12 * sizeof(float)));
-        }
-
-        if (attrCosine != -1) {
-            context->glEnableVertexAttribArray(attrCosine);
-            context->glVertexAttribPointer(attrCosine, 1, GL_FLOAT, false,
-                                           16 * sizeof(float), (void*)(14 * sizeof(float)));
-        }
-        if (attrAnimated != -1) {
-            context->glEnableVertexAttribArray(attrAnimated);
-            context->glVertexAttribPointer(attrAnimated, 1, GL_FLOAT, false,
-                                           16 * sizeof(float), (void*)(15 * sizeof(float)));
-        }
+        enableAttributes(d);
         // Bind the index buffer and then draw shapes from it.
         // This invokes the shader program, which accesses the vertex buffers.
         d.bindIdx0();
         context->glDrawElements(d.drawMode(), d.elemCount0(), GL_UNSIGNED_INT, 0);
-
-        if (attrPos != -1) context->glDisableVertexAttribArray(attrPos);
-        if (attrNor != -1) context->glDisableVertexAttribArray(attrNor);
-        if (attrCol != -1) context->glDisableVertexAttribArray(attrCol);
-        if (attrUV != -1) context->glDisableVertexAttribArray(attrUV);
-        if (attrCosine != -1) context->glDisableVertexAttribArray(attrCosine);
     }
     else {
         // Transparency
         d.bindVer1();
+        enableAttributes(d);
+        // Bind the index buffer and then draw shapes from it.
+        // This invokes the shader program, which accesses the vertex buffers.
+        d.bindIdx1();
+        context->glDrawElements(d.drawMode(), d.elemCount1(), GL_UNSIGNED_INT, 0);
+    }
+    disableAttributes();
+    context->printGLErrorLog();
+}
 
-        if (attrPos != -1) {
-            context->glEnableVertexAttribArray(attrPos);
-            context->glVertexAttribPointer(attrPos, 4, GL_FLOAT, false,
-                                           16 * sizeof(float), (void*)0);
+void ShaderProgram::enableAttributes(Drawable &d)
+{
+    if (d.isPacked()) {
+        // Two GLuints per vertex, read as integers rather than normalized floats
+        if (attrPacked != -1) {
+            context->glEnableVertexAttribArray(attrPacked);
+            context->glVertexAttribIPointer(attrPacked, 2, GL_UNSIGNED_INT,
+                                            2 * sizeof(GLuint), (void*)0);
         }
+        return;
+    }
 
-        if (attrNor != -1) {
-            context->glEnableVertexAttribArray(attrNor);
-            context->glVertexAttribPointer(attrNor, 4, GL_FLOAT, false,
-                                           16 * sizeof(float), (void*)(4 * sizeof(float)));
-        }
+    if (attrPos != -1) {
+        context->glEnableVertexAttribArray(attrPos);
+        context->glVertexAttribPointer(attrPos, 4, GL_FLOAT, false,
+                                       16 * sizeof(float), (void*)0);
+    }
 
-        if (attrCol != -1) {
-            context->glEnableVertexAttribArray(attrCol);
-            context->glVertexAttribPointer(attrCol, 4, GL_FLOAT, false,
-                                           16 * sizeof(float), (void*)(8 * sizeof(float)));
-        }
+    if (attrNor != -1) {
+        context->glEnableVertexAttribArray(attrNor);
+        context->glVertexAttribPointer(attrNor, 4, GL_FLOAT, false,
+                                       16 * sizeof(float), (void*)(4 * sizeof(float)));
+    }
 
-        if (attrUV != -1) {
-            context->glEnableVertexAttribArray(attrUV);
-            context->glVertexAttribPointer(attrUV, 2, GL_FLOAT, false,
-                                           16 * sizeof(float), (void*)(12 * sizeof(float)));
-        }
+    if (attrCol != -1) {
+        context->glEnableVertexAttribArray(attrCol);
+        context->glVertexAttribPointer(attrCol, 4, GL_FLOAT, false,
+                                       16 * sizeof(float), (void*)(8 * sizeof(float)));
+    }
 
-        if (attrCosine != -1) {
-            context->glEnableVertexAttribArray(attrCosine);
-            context->glVertexAttribPointer(attrCosine, 1, GL_FLOAT, false,
-                                           16 * sizeof(float), (void*)(14 * sizeof(float)));
-        }
-        if (attrAnimated != -1) {
-            context->glEnableVertexAttribArray(attrAnimated);
-            context->glVertexAttribPointer(attrAnimated, 1, GL_FLOAT, false,
-                                           16 * sizeof(float), (void*)(15 * sizeof(float)));
-        }
-        // Bind the index buffer and then draw shapes from it.
-        // This invokes the shader program, which accesses the vertex buffers.
-        d.bindIdx1();
-        context->glDrawElements(d.drawMode(), d.elemCount1(), GL_UNSIGNED_INT, 0);
+    if (attrUV != -1) {
+        context->glEnableVertexAttribArray(attrUV);
+        context->glVertexAttribPointer(attrUV, 2, GL_FLOAT, false,
+                                       16 * sizeof(float), (void*)(12 * sizeof(float)));
+    }
 
-        if (attrPos != -1) context->glDisableVertexAttribArray(attrPos);
-        if (attrNor != -1) context->glDisableVertexAttribArray(attrNor);
-        if (attrCol != -1) context->glDisableVertexAttribArray(attrCol);
-        if (attrUV != -1) context->glDisableVertexAttribArray(attrUV);
-        if (attrCosine != -1) context->glDisableVertexAttribArray(attrCosine);
+    if (attrCosine != -1) {
+        context->glEnableVertexAttribArray(attrCosine);
+        context->glVertexAttribPointer(attrCosine, 1, GL_FLOAT, false,
+                                       16 * sizeof(float), (void*)(14 * sizeof(float)));
     }
-    context->printGLErrorLog();
+    if (attrAnimated != -1) {
+        context->glEnableVertexAttribArray(attrAnimated);
+        context->glVertexAttribPointer(attrAnimated, 1, GL_FLOAT, false,
+                                       16 * sizeof(float), (void*)(15 * sizeof(float)));
+    }
+}
+
+void ShaderProgram::disableAttributes()
+{
+    if (attrPos != -1) context->glDisableVertexAttribArray(attrPos);
+    if (attrNor != -1) context->glDisableVertexAttribArray(attrNor);
+    if (attrCol != -1) context->glDisableVertexAttribArray(attrCol);
+    if (attrUV != -1) context->glDisableVertexAttribArray(attrUV);
+    if (attrCosine != -1) context->glDisableVertexAttribArray(attrCosine);
+    if (attrAnimated != -1) context->glDisableVertexAttribArray(attrAnimated);
+    if (attrPacked != -1) context->glDisableVertexAttribArray(attrPacked);
 }
 
 char* ShaderProgram::textFileRead(const char* fileName) {
@@ -21,6 +21,7 @@ public:
     int attrUV; // A handle for the "in" vec2 representing UV in the vertex shader
     int attrCosine; // A handle for the "in" float representing cosine in the vertex shader
     int attrAnimated; // A handle for the "in" int representing block type in the vertex shader
+    int attrPacked; // A handle for the "in" uvec2 representing a packed chunk vertex in the vertex shader
 
 
     int unifModel; // A handle for the "uniform" mat4 representing model matrix in the vertex shader
@@ -31,6 +32,8 @@ public:
     int unifTime; // A handle for the "uniform" vec4 representing time
     int unifBlendType; // A handle for the "uniform" vec4 representing blend type
     int unifEnvironm; // A handle for the "uniform" int representing environment(lava, water)
+    int unifPacked; // A handle for the "uniform" int telling whether vertices are packed
+    int unifChunkOrigin; // A handle for the "uniform" vec3 representing the origin of the chunk being drawn
 
     // Sky
     int unifDimensions;
@@ -67,6 +70,10 @@ public:
     QString qTextFileRead(const char*);
 
 private:
+    // Point the vertex attributes at the currently bound VBO of the Drawable
+    void enableAttributes(Drawable &d);
+    void disableAttributes();
+
     OpenGLContext* context;   // Since Qt's OpenGL support is done through classes like QOpenGLFunctions_3_2_Core,
                             // we need to pass our OpenGL context to the Drawable in order to call GL functions
                             // from within this class.
@@ -13,9 +13,14 @@ SOURCES += \
     $$PWD/scene/transform.cpp \
     $$PWD/openglcontext.cpp \
     $$PWD/scene/terrain.cpp \
+    $$PWD/scene/chunkmap.cpp \
+    $$PWD/scene/blockcursor.cpp \
+    $$PWD/scene/chunkscheduler.cpp \
+    $$PWD/scene/regionstore.cpp \
     $$PWD/scene/worldaxes.cpp \
     $$PWD/player.cpp \
     $$PWD/worker.cpp \
+    $$PWD/jobsystem.cpp \
     $$PWD/texture.cpp \
     $$PWD/scene/lsystem.cpp \
     $$PWD/scene/rectangle.cpp \
@@ -24,7 +29,13 @@ SOURCES += \
     $$PWD/scene/lightening.cpp \
     $$PWD/scene/snow.cpp \
     $$PWD/scene/chunk.cpp \
+    $$PWD/scene/blocksection.cpp \
+    $$PWD/scene/faceculling.cpp \
+    $$PWD/scene/chunksnapshot.cpp \
     $$PWD/scene/biome.cpp \
+    $$PWD/scene/noise.cpp \
+    $$PWD/scene/climatefield.cpp \
+    $$PWD/scene/biomemap.cpp \
     $$PWD/scene/terrainart.cpp \
     $$PWD/scene/npcsystem.cpp
 
@@ -40,18 +51,29 @@ HEADERS += \
     $$PWD/scene/transform.h \
     $$PWD/openglcontext.h \
     $$PWD/scene/terrain.h \
+    $$PWD/scene/chunkmap.h \
+    $$PWD/scene/blockcursor.h \
+    $$PWD/scene/chunkscheduler.h \
+    $$PWD/scene/regionstore.h \
     $$PWD/scene/worldaxes.h \
     $$PWD/smartpointerhelp.h \
     $$PWD/scene/noise.h \
     $$PWD/player.h \
     $$PWD/worker.h \
+    $$PWD/completionqueue.h \
+    $$PWD/jobsystem.h \
     $$PWD/texture.h \
     $$PWD/scene/lsystem.h \
     $$PWD/scene/rectangle.h \
     $$PWD/scene/quad.h \
     $$PWD/scene/raindrop.h \
     $$PWD/scene/chunk.h \
+    $$PWD/scene/blocksection.h \
+    $$PWD/scene/faceculling.h \
+    $$PWD/scene/chunksnapshot.h \
     $$PWD/scene/lightening.h \
     $$PWD/scene/snow.h \
     $$PWD/scene/biome.h \
+    $$PWD/scene/climatefield.h \
+    $$PWD/scene/biomemap.h \
     $$PWD/scene/npcsystem.h
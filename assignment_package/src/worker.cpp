@@ -1,34 +1,52 @@
 #include "worker.h"
 #include <iostream>
 
-void Worker::run()
+// compute the maps unless every chunk of the group was cancelled, on any thread
+void StreamingGroup::build()
 {
-    int x = m_rect.xmid();
-    int z = m_rect.zmid();
-    ThreadData::workerRect = m_rect;
-    m_terrain->buildChunk(x, z);
-    m_lsystem->update(m_rect);
-    m_terrain->placeAssets(m_rect);
-    Chunk* chunk = m_terrain->getChunk(m_rect.xmid(), m_rect.zmid());
-    ChunkCreateInfo info;
-    ChunkCreateInfo li;
-    ChunkCreateInfo ri;
-    ChunkCreateInfo fi;
-    ChunkCreateInfo bi;
-    chunk->populateInfo(&info);
-    chunk->populateNeighbor(&li, &ri, &fi, &bi);
-    ThreadData::info = info;
-    ThreadData::linfo = li;
-    ThreadData::rinfo = ri;
-    ThreadData::finfo = fi;
-    ThreadData::binfo = bi;
-    ThreadData::workerRunning = 2;
+    for (const sPtr<CancelToken>& token : tokens) {
+        if (!token->isCancelled()) {
+            BiomeMap::buildGroup(x0, z0, chunksX, chunksZ, maps.data());
+            return;
+        }
+    }
 }
 
-int ThreadData::workerRunning = 0;
-Rect16 ThreadData::workerRect = Rect16(0, 0);
-ChunkCreateInfo ThreadData::info = ChunkCreateInfo();
-ChunkCreateInfo ThreadData::linfo = ChunkCreateInfo();
-ChunkCreateInfo ThreadData::rinfo = ChunkCreateInfo();
-ChunkCreateInfo ThreadData::finfo = ChunkCreateInfo();
-ChunkCreateInfo ThreadData::binfo = ChunkCreateInfo();
+// the map of the chunk at a chunk origin inside the group
+const BiomeMap* StreamingGroup::map(int x, int z) const
+{
+    return &maps[(z - z0) / 16 * chunksX + (x - x0) / 16];
+}
+
+// take the dirty sections of a chunk and a copy of its blocks, on the main thread
+void RemeshJob::prepare(Chunk* chunk)
+{
+    this->chunk = chunk;
+    sections = chunk->takeDirtySections();
+    edges = chunk->takeDirtyEdges();
+    stamp = chunk->nextMeshStamp();
+    blocks.capture(*chunk);
+}
+
+// mesh the copy, on any thread
+void RemeshJob::mesh()
+{
+    for (int section = 0; section < CHUNK_SECTIONS; section++) {
+        if (sections & (1 << section)) {
+            Chunk::populateSection(blocks, &info, section);
+        }
+    }
+    for (int edge = 0; edge < CHUNK_EDGES; edge++) {
+        if (edges & (1 << edge)) {
+            Chunk::populateEdge(blocks, &info, FaceType(edge));
+        }
+    }
+}
+
+// move the meshes into the chunk and upload it, on the main thread
+void RemeshJob::apply()
+{
+    if (chunk != nullptr) {
+        chunk->updateSections(&info, sections, edges, stamp);
+    }
+}
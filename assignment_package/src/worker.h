@@ -3,37 +3,70 @@
 
 #pragma once
 
-#include <QRunnable>
-#include <QThread>
 #include "scene/terrain.h"
 #include "scene/lsystem.h"
+#include "scene/chunksnapshot.h"
+#include "jobsystem.h"
 
-class Worker : public QRunnable
+// the biome maps of adjacent chunks streaming in together, computed in one pass
+// by a job their generate jobs wait for, see Terrain::buildFbmGroup
+class StreamingGroup
 {
-private:
-    Terrain *m_terrain;
-    LSystem *m_lsystem;
-    Rect16 m_rect;
 public:
-    Worker(Terrain* terrain, LSystem *lsystem, const Rect16 &rect):
-        m_terrain(terrain), m_lsystem(lsystem), m_rect(rect) {}
-    void run() override;
+    StreamingGroup(int x0, int z0, int chunksX, int chunksZ):
+        x0(x0), z0(z0), chunksX(chunksX), chunksZ(chunksZ), maps(chunksX * chunksZ), tokens() {}
+    // compute the maps unless every chunk of the group was cancelled, on any thread
+    void build();
+    // the map of the chunk at a chunk origin inside the group
+    const BiomeMap* map(int x, int z) const;
+
+    // the origin of the first chunk and the number of chunks along x and z
+    int x0, z0;
+    int chunksX, chunksZ;
+    std::vector<BiomeMap> maps;
+    // the cancel tokens of the chunks of the group
+    std::vector<sPtr<CancelToken>> tokens;
+};
+
+// a chunk on its way into the terrain, its jobs share the cancel token
+// so they are skipped once the player has left the chunk behind
+class StreamingChunk
+{
+public:
+    StreamingChunk(const Rect16 &rect):
+        rect(rect), token(mkS<CancelToken>()), chunk(nullptr), loaded(false), group(nullptr) {}
+    Rect16 rect;
+    sPtr<CancelToken> token;
+    // the generated blocks, handed from the generate job to the decorate job
+    uPtr<Chunk> chunk;
+    // whether the blocks were loaded whole from the saved world, already decorated
+    bool loaded;
+    // the group computing the chunk's biome map, if it streams in with its neighbors
+    sPtr<StreamingGroup> group;
 };
 
-class ThreadData
+// the sections of a chunk to remesh and their new meshes
+class RemeshJob
 {
 public:
-    // determine whether the thread worker is running
-    // 0: not running, 1: running, 2: just finished
-    static int workerRunning;
-    // the rect that the worker is running on
-    static Rect16 workerRect;
-    // chunk create infos
-    static ChunkCreateInfo info;
-    static ChunkCreateInfo linfo;
-    static ChunkCreateInfo rinfo;
-    static ChunkCreateInfo finfo;
-    static ChunkCreateInfo binfo;
+    RemeshJob(): chunk(nullptr), sections(0), edges(0), stamp(0) {}
+    // take the dirty sections of a chunk and a copy of its blocks, on the main thread
+    void prepare(Chunk* chunk);
+    // mesh the copy, on any thread
+    void mesh();
+    // move the meshes into the chunk and upload it, on the main thread
+    void apply();
+
+    Chunk* chunk;
+    // bit i is set when section i is remeshed
+    uint16_t sections;
+    // bit i is set when edge strip i is remeshed
+    uint8_t edges;
+    // orders the jobs of a chunk, see Chunk::nextMeshStamp
+    uint32_t stamp;
+    // the blocks at the time the job was prepared
+    ChunkSnapshot blocks;
+    ChunkCreateInfo info;
 };
 
 #endif // WORKER_H
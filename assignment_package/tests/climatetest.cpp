@@ -0,0 +1,56 @@
+#include <cmath>
+#include <vector>
+#include "tests.h"
+#include "scene/biome.h"
+
+// columns per side of the block swept under each seed
+static const int SWEEP = 512;
+
+// reaches the climate parameters of Biome
+class ClimateTest
+{
+public:
+    static int run();
+};
+
+int testClimateBound() {
+    return ClimateTest::run();
+}
+
+// ClimateField stays within CLIMATE_MAX_ERROR of sealedFbm2D over a sweep of columns
+// under several seeds, and grid gives the same values as sample
+int ClimateTest::run() {
+    Biome::InitializeParams();
+    noise::backend = noise::HASH_BACKEND;
+    const uint32_t seeds[] = {1u, 42u, 99u, 777u, 123456u, 0xdeadbeefu};
+    int failures = 0;
+    float worst = 0.f;
+    for (uint32_t seed : seeds) {
+        noise::worldSeed = seed;
+        // cached areas only hold for one seed
+        ClimateField climate(Biome::moisturePars, Biome::temperaturePars);
+        // a different origin for every seed, some of them negative
+        int x0 = (int)(seed % 4096) - 2048;
+        int z0 = (int)(seed / 4096 % 4096) - 2048;
+        std::vector<float> moistures(SWEEP * SWEEP), temperatures(SWEEP * SWEEP);
+        climate.grid(x0, z0, SWEEP, SWEEP, moistures.data(), temperatures.data());
+        bool withinBound = true, gridMatches = true;
+        for (int j = 0; j < SWEEP; j++) {
+            for (int i = 0; i < SWEEP; i++) {
+                int x = x0 + i, z = z0 + j;
+                float moisture, temperature;
+                climate.sample(x, z, moisture, temperature);
+                float error = std::max(std::fabs(moisture - noise::sealedFbm2D(x, z, Biome::moisturePars)),
+                                       std::fabs(temperature - noise::sealedFbm2D(x, z, Biome::temperaturePars)));
+                worst = std::max(worst, error);
+                withinBound = withinBound && error <= CLIMATE_MAX_ERROR;
+                gridMatches = gridMatches && moistures[j * SWEEP + i] == moisture &&
+                        temperatures[j * SWEEP + i] == temperature;
+            }
+        }
+        failures += check(withinBound, "coarse climate within CLIMATE_MAX_ERROR of sealedFbm2D");
+        failures += check(gridMatches, "ClimateField::grid matches ClimateField::sample");
+    }
+    std::cout << "coarse climate worst error " << worst << " of " << CLIMATE_MAX_ERROR << std::endl;
+    return failures;
+}
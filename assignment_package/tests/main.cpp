@@ -0,0 +1,14 @@
+#include "tests.h"
+
+int main() {
+    int failures = 0;
+    failures += testHashBackend();
+    failures += testGridEquivalence();
+    failures += testClimateBound();
+    if (failures > 0) {
+        std::cerr << failures << " checks failed" << std::endl;
+        return 1;
+    }
+    std::cout << "all tests passed" << std::endl;
+    return 0;
+}
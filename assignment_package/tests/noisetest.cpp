@@ -0,0 +1,108 @@
+#include <vector>
+#include "tests.h"
+#include "scene/noise.h"
+
+// a column and the hash backend's values there under the seed 12345, columnRand and
+// fbm2D as float bits, sealedFbm2D with climate-like parameters, recorded when the
+// backend was introduced, saved worlds regenerate their chunks from these values
+struct StableColumn {
+    int x, z;
+    uint32_t columnRand;
+    uint32_t fbm;
+    int sealedFbm;
+};
+
+static const StableColumn STABLE_COLUMNS[] = {
+    {0, 0, 0x3d452730u, 0x3e9c0c84u, 20},
+    {17, -5, 0x3ef54808u, 0x3ea28de8u, 22},
+    {-1000, 123456, 0x3edbd32au, 0x3e94efbeu, 51},
+    {2000000, -3000000, 0x3f71d6c3u, 0x3f0e269eu, 35}
+};
+
+// the hash backend still gives the values recorded when it was introduced
+int testHashBackend() {
+    noise::backend = noise::HASH_BACKEND;
+    noise::worldSeed = 12345u;
+    noise::fbmParams p;
+    p.exponent = 1;
+    p.scaleX = 0.002f;
+    p.scaleY = 100.f;
+    p.scaleZ = 0.002f;
+    p.seed1 = 123.4f;
+    int failures = 0;
+    for (const StableColumn& c : STABLE_COLUMNS) {
+        float fbm = noise::fbm2D(c.x * 0.02f, c.z * 0.02f, 0.5f, 8, 12.9898f, 4.1414f, 43858.5453f);
+        int grid = 0;
+        noise::sealedFbmGrid(c.x, c.z, 1, 1, p, &grid);
+        failures += check(noise::floatBits(noise::columnRand(c.x, c.z, 123.4f, 345.6f, 456.7f)) == c.columnRand,
+                          "hash backend columnRand");
+        failures += check(noise::floatBits(fbm) == c.fbm, "hash backend fbm2D");
+        failures += check(noise::sealedFbm2D(c.x, c.z, p) == c.sealedFbm, "hash backend sealedFbm2D");
+        failures += check(grid == c.sealedFbm, "hash backend sealedFbmGrid");
+    }
+    return failures;
+}
+
+// grid origins, across zero and far out, and the columns per side of each grid
+static const int GRID_ORIGINS[][2] = {{-40, -24}, {0, 0}, {-5000, 7000}, {1000000, -2000000}};
+static const int GRID_SIDE = 64;
+
+// a grid kernel gives exactly sealedFbm2D at every column of each grid origin
+static int checkGrid(void (*kernel)(int, int, int, int, const noise::fbmParams&, int*),
+                     const noise::fbmParams &p, const char *what) {
+    std::vector<int> grid(GRID_SIDE * GRID_SIDE);
+    bool matches = true;
+    for (const auto& origin : GRID_ORIGINS) {
+        kernel(origin[0], origin[1], GRID_SIDE, GRID_SIDE, p, grid.data());
+        for (int j = 0; j < GRID_SIDE; j++) {
+            for (int i = 0; i < GRID_SIDE; i++) {
+                matches = matches &&
+                        grid[j * GRID_SIDE + i] == noise::sealedFbm2D(origin[0] + i, origin[1] + j, p);
+            }
+        }
+    }
+    return check(matches, what);
+}
+
+// every sealedFbmGrid kernel gives exactly sealedFbm2D over multi-chunk grids,
+// under both backends
+int testGridEquivalence() {
+    noise::worldSeed = 12345u;
+    const noise::Backend backends[] = {noise::SIN_BACKEND, noise::HASH_BACKEND};
+    const int exponents[] = {1, 2, 3, 4, 5};
+    int failures = 0;
+    for (noise::Backend backend : backends) {
+        noise::backend = backend;
+        for (int exponent : exponents) {
+            // terrain-like parameters, the lattice cells of the low octaves span many columns
+            noise::fbmParams p;
+            p.exponent = exponent;
+            p.scaleX = 0.003f;
+            p.scaleY = 100.f;
+            p.scaleZ = 0.004f;
+            p.offsetX = 17;
+            p.offsetZ = -9;
+            p.offsetY = 64;
+            p.seed1 = 123.4f;
+            failures += checkGrid(noise::sealedFbmGrid, p, "sealedFbmGrid");
+            failures += checkGrid(noise::sealedFbmGrid<0, 0>, p, "sealedFbmGrid<0, 0>");
+            switch (exponent) {
+            case 1:
+                failures += checkGrid(noise::sealedFbmGrid<8, 1>, p, "sealedFbmGrid<8, 1>");
+                break;
+            case 3:
+                failures += checkGrid(noise::sealedFbmGrid<8, 3>, p, "sealedFbmGrid<8, 3>");
+                break;
+            case 4:
+                failures += checkGrid(noise::sealedFbmGrid<8, 4>, p, "sealedFbmGrid<8, 4>");
+                break;
+            case 5:
+                failures += checkGrid(noise::sealedFbmGrid<8, 5>, p, "sealedFbmGrid<8, 5>");
+                break;
+            default:
+                break;
+            }
+        }
+    }
+    return failures;
+}
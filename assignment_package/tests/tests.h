@@ -0,0 +1,21 @@
+#pragma once
+#include <iostream>
+
+// report a failed check, return 1 when it failed so the failures can be summed
+inline int check(bool passed, const char *what) {
+    if (!passed) {
+        std::cerr << "FAILED: " << what << std::endl;
+    }
+    return passed ? 0 : 1;
+}
+
+// each test returns its number of failed checks
+
+// the hash backend still gives the values recorded when it was introduced
+int testHashBackend();
+// every sealedFbmGrid kernel gives exactly sealedFbm2D over multi-chunk grids,
+// under both backends
+int testGridEquivalence();
+// ClimateField stays within CLIMATE_MAX_ERROR of sealedFbm2D over a sweep of columns
+// under several seeds, and grid gives the same values as sample
+int testClimateBound();
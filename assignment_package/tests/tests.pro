@@ -0,0 +1,29 @@
+# checks of the world generation that need no window or GL context,
+# build and run in both debug and release, worlds must generate the same in every build
+
+TARGET = MiniMinecraftTests
+TEMPLATE = app
+CONFIG += console
+CONFIG += c++1z
+CONFIG -= qt
+CONFIG += warn_on
+
+INCLUDEPATH += ../src ../include
+
+SOURCES += \
+    main.cpp \
+    noisetest.cpp \
+    climatetest.cpp \
+    ../src/scene/noise.cpp \
+    ../src/scene/biome.cpp \
+    ../src/scene/climatefield.cpp
+
+HEADERS += \
+    tests.h
+
+*-clang*|*-g++* {
+    CONFIG -= warn_on
+    QMAKE_CXXFLAGS += -Wall -Wextra -pedantic
+    # the same float code generation as the game, the recorded values depend on it
+    QMAKE_CXXFLAGS += -ffp-contract=off
+}